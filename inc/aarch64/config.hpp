@@ -17,4 +17,8 @@
 
 #pragma once
 
+#include "board.hpp"
+
 #define CFG_VER         8
+
+#define NUM_CPU         (CL0_CORES + CL1_CORES)
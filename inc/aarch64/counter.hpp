@@ -0,0 +1,32 @@
+/*
+ * Event Counters
+ *
+ * Copyright (C) 2019 Udo Steinberg, BedRock Systems, Inc.
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include "compiler.hpp"
+
+class Counter
+{
+    public:
+        static unsigned tlb_local       CPULOCAL;   // TLB invalidations on this CPU only
+        static unsigned tlb_remote      CPULOCAL;   // TLB invalidations broadcast to other CPUs
+        static unsigned timer_saved     CPULOCAL;   // Timer interrupts saved by coalescing timeouts
+        static unsigned vcpu_kept       CPULOCAL;   // vCPU entries that found their EL1 and vGIC state still live
+        static unsigned vcpu_load       CPULOCAL;   // vCPU entries that had to reload their EL1 and vGIC state
+
+        static void dump();
+};
@@ -0,0 +1,41 @@
+/*
+ * CPU Set
+ *
+ * Copyright (C) 2019 Udo Steinberg, BedRock Systems, Inc.
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include "atomic.hpp"
+#include "compiler.hpp"
+#include "types.hpp"
+
+class Cpuset
+{
+    private:
+        mword val;
+
+    public:
+        ALWAYS_INLINE
+        inline explicit Cpuset() : val (0) {}
+
+        ALWAYS_INLINE
+        inline bool chk (unsigned cpu) const { return val & 1UL << cpu; }
+
+        ALWAYS_INLINE
+        inline bool only (unsigned cpu) const { return !(Atomic::load (val) & ~(1UL << cpu)); }
+
+        ALWAYS_INLINE
+        inline void set (unsigned cpu) { Atomic::set_mask (val, 1UL << cpu); }
+};
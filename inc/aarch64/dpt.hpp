@@ -25,7 +25,12 @@ class Dptp : public Npt
 
     public:
         ALWAYS_INLINE
-        inline void flush (Vmid)
+        inline void flush (Vmid, bool)
+        {
+        }
+
+        ALWAYS_INLINE
+        inline void flush (Vmid, bool, uint64, unsigned)
         {
         }
 };
@@ -38,6 +38,7 @@
 class Ec : private Kobject, public Queue<Sc>
 {
     friend class Queue<Ec>;
+    friend class Sm;
 
     private:
         Exc_regs            regs            ALIGNED (16);
@@ -55,7 +56,13 @@ class Ec : private Kobject, public Queue<Sc>
         Ec *                callee          { nullptr };
         Ec *                caller          { nullptr };
         unsigned            hazard          { 0 };
+        unsigned            fpu_traps       { 0 };      // FPU switches on first use
+        unsigned            fpu_loads       { 0 };      // FPU switches ahead of use
+        unsigned            fpu_score       { 0 };
         Timeout_hypercall   timeout         { this };
+        unsigned long       pt_sel          { 0 };
+        mword               pt_gen          { ~0UL };
+        Capability          pt_cap          { 0 };
 
         static Slab_cache   cache;
 
@@ -65,6 +72,22 @@ class Ec : private Kobject, public Queue<Sc>
         ALWAYS_INLINE
         inline Sys_regs *sys_regs() { return &regs; }
 
+        // Portal lookup that reuses the previous result while the capability space is unchanged
+        ALWAYS_INLINE
+        inline Capability lookup_pt (unsigned long sel)
+        {
+            mword g = Atomic::load (pd->Space_obj::gen);
+
+            if (EXPECT_TRUE (pt_sel == sel && pt_gen == g))
+                return pt_cap;
+
+            pt_cap = pd->Space_obj::lookup (sel);
+            pt_sel = sel;
+            pt_gen = g;
+
+            return pt_cap;
+        }
+
         ALWAYS_INLINE
         inline void set_partner (Ec *e)
         {
@@ -106,6 +129,11 @@ class Ec : private Kobject, public Queue<Sc>
         NORETURN
         static void send_msg();
 
+        // Each FPU trap raises the score, each switch to this EC without owning the FPU lowers it
+        static unsigned const fpu_boost = 16, fpu_eager = 16, fpu_limit = 64;
+
+        void claim_fpu();
+        void adapt_fpu();
         void switch_fpu();
 
         static void handle_irq_kern() asm ("irq_kern_handler");
@@ -176,6 +204,10 @@ class Ec : private Kobject, public Queue<Sc>
         ALWAYS_INLINE NORETURN
         inline void make_current()
         {
+            // Switch FPU state ahead of use for ECs that keep using it
+            if (EXPECT_FALSE (fpu_score) && fpowner != this)
+                adapt_fpu();
+
             // Become current EC
             current = this;
 
@@ -214,10 +246,10 @@ class Ec : private Kobject, public Queue<Sc>
         inline void clr_hazard (unsigned h) { Atomic::clr_mask (hazard, h); }
 
         ALWAYS_INLINE
-        inline void set_timeout (uint64 t, Sm *s)
+        inline void set_timeout (uint64 t, uint64 l, Sm *s)
         {
             if (EXPECT_FALSE (t))
-                timeout.enqueue (t, s);
+                timeout.enqueue (t, l, s);
         }
 
         ALWAYS_INLINE
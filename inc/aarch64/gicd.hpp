@@ -101,6 +101,8 @@ class Gicd : private Coresight, private Intid
 
         static void conf (unsigned, bool = true, unsigned = 0);
 
+        static void route (unsigned, unsigned);
+
         static void mask (unsigned, bool);
 
         static void send_sgi (unsigned, unsigned);
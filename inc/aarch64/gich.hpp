@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include "arch.hpp"
 #include "barrier.hpp"
 #include "gicc.hpp"
 #include "memory.hpp"
@@ -82,12 +83,96 @@ class Gich
         static void init_regs();
         static void init_mmio();
 
+        static inline uint64 get_lr (unsigned i)
+        {
+            switch (i) {
+                default:
+                case 15: return get_el2_lr15();
+                case 14: return get_el2_lr14();
+                case 13: return get_el2_lr13();
+                case 12: return get_el2_lr12();
+                case 11: return get_el2_lr11();
+                case 10: return get_el2_lr10();
+                case  9: return get_el2_lr9();
+                case  8: return get_el2_lr8();
+                case  7: return get_el2_lr7();
+                case  6: return get_el2_lr6();
+                case  5: return get_el2_lr5();
+                case  4: return get_el2_lr4();
+                case  3: return get_el2_lr3();
+                case  2: return get_el2_lr2();
+                case  1: return get_el2_lr1();
+                case  0: return get_el2_lr0();
+            }
+        }
+
     public:
         static unsigned num_apr CPULOCAL;
         static unsigned num_lr  CPULOCAL;
 
         static void init();
 
+        // List register in GIC format, converted from the GICv3 layout
+        static uint64 lr_gic (uint64 v)
+        {
+            if (Gicc::mode == Gicc::Mode::REGS)
+                return v;
+
+            return (v & 0xc000000000000000) >> 34 |     // State (2 bits)
+                   (v & 0x3000000000000000) >> 30 |     // HW + Grp (2 bits)
+                   (v & 0x00f8000000000000) >> 28 |     // Priority (5 bits)
+                   (v & 0x000003ff00000000) >> 22 |     // pINTID (10 bits)
+                   (v & 0x00000000000003ff);            // vINTID (10 bits)
+        }
+
+        // List register in GIC format is neither in use nor waiting for an EOI maintenance interrupt
+        static bool lr_free (uint64 v)
+        {
+            if (Gicc::mode == Gicc::Mode::REGS)
+                return !(v & BIT64_RANGE (63, 62)) && (v & BIT64 (61) || !(v & BIT64 (41)));
+
+            return !(v & BIT64_RANGE (29, 28)) && (v & BIT64 (31) || !(v & BIT64 (19)));
+        }
+
+        static void set_lr (unsigned i, uint64 v)
+        {
+            if (Gicc::mode == Gicc::Mode::REGS) {
+
+                switch (i) {
+                    default:
+                    case 15: set_el2_lr15 (v); break;
+                    case 14: set_el2_lr14 (v); break;
+                    case 13: set_el2_lr13 (v); break;
+                    case 12: set_el2_lr12 (v); break;
+                    case 11: set_el2_lr11 (v); break;
+                    case 10: set_el2_lr10 (v); break;
+                    case  9: set_el2_lr9  (v); break;
+                    case  8: set_el2_lr8  (v); break;
+                    case  7: set_el2_lr7  (v); break;
+                    case  6: set_el2_lr6  (v); break;
+                    case  5: set_el2_lr5  (v); break;
+                    case  4: set_el2_lr4  (v); break;
+                    case  3: set_el2_lr3  (v); break;
+                    case  2: set_el2_lr2  (v); break;
+                    case  1: set_el2_lr1  (v); break;
+                    case  0: set_el2_lr0  (v); break;
+                }
+
+                Barrier::isb();
+
+            } else
+                write (Array32::LR, i, static_cast<uint32>(v));
+        }
+
+        static void enable (uint32 hcr)
+        {
+            if (Gicc::mode == Gicc::Mode::REGS) {
+                set_el2_hcr (hcr);
+                Barrier::isb();
+            } else
+                write (Register32::HCR, hcr);
+        }
+
         static void disable()
         {
             if (Gicc::mode == Gicc::Mode::REGS) {
@@ -149,30 +234,15 @@ class Gich
             }
         }
 
+        // Empty list registers keep their last contents, only with the state cleared
         static void save (uint64 (&lr)[16], uint32 (&ap0r)[4], uint32 (&ap1r)[4], uint32 &hcr, uint32 &vmcr, uint32 &elrsr)
         {
             if (Gicc::mode == Gicc::Mode::REGS) {
 
-                switch (num_lr) {
-                    default:
-                    case 16: lr[15] = get_el2_lr15(); FALLTHROUGH;
-                    case 15: lr[14] = get_el2_lr14(); FALLTHROUGH;
-                    case 14: lr[13] = get_el2_lr13(); FALLTHROUGH;
-                    case 13: lr[12] = get_el2_lr12(); FALLTHROUGH;
-                    case 12: lr[11] = get_el2_lr11(); FALLTHROUGH;
-                    case 11: lr[10] = get_el2_lr10(); FALLTHROUGH;
-                    case 10: lr[9]  = get_el2_lr9();  FALLTHROUGH;
-                    case  9: lr[8]  = get_el2_lr8();  FALLTHROUGH;
-                    case  8: lr[7]  = get_el2_lr7();  FALLTHROUGH;
-                    case  7: lr[6]  = get_el2_lr6();  FALLTHROUGH;
-                    case  6: lr[5]  = get_el2_lr5();  FALLTHROUGH;
-                    case  5: lr[4]  = get_el2_lr4();  FALLTHROUGH;
-                    case  4: lr[3]  = get_el2_lr3();  FALLTHROUGH;
-                    case  3: lr[2]  = get_el2_lr2();  FALLTHROUGH;
-                    case  2: lr[1]  = get_el2_lr1();  FALLTHROUGH;
-                    case  1: lr[0]  = get_el2_lr0();  FALLTHROUGH;
-                    case  0: break;
-                }
+                elrsr = static_cast<uint32>(get_el2_elrsr());
+
+                for (unsigned i = 0; i < num_lr; i++)
+                    lr[i] = elrsr & BIT (i) ? lr[i] & ~BIT64_RANGE (63, 62) : get_lr (i);
 
                 switch (num_apr) {
                     default:
@@ -183,19 +253,19 @@ class Gich
                     case  0: break;
                 }
 
-                elrsr = static_cast<uint32>(get_el2_elrsr());
                 vmcr  = static_cast<uint32>(get_el2_vmcr());
                 hcr   = static_cast<uint32>(get_el2_hcr());
 
             } else {
 
+                elrsr = read (Register32::ELRSR);
+
                 for (unsigned i = 0; i < num_lr; i++)
-                    lr[i] = read (Array32::LR, i);
+                    lr[i] = elrsr & BIT (i) ? lr[i] & ~BIT64_RANGE (29, 28) : read (Array32::LR, i);
 
                 for (unsigned i = 0; i < num_apr; i++)
                     ap1r[i] = read (Array32::APR, i);
 
-                elrsr = read (Register32::ELRSR);
                 vmcr  = read (Register32::VMCR);
                 hcr   = read (Register32::HCR);
             }
@@ -22,6 +22,7 @@
 #include "types.hpp"
 
 class Sm;
+class Vmcb;
 
 class Interrupt : private Intid
 {
@@ -38,9 +39,12 @@ class Interrupt : private Intid
         };
 
         Sm *    sm  { nullptr };
+        Vmcb *  vmb { nullptr };    // Injected into this vCPU by the kernel
+        uint64  tpl { 0 };          // List register template for injection
         uint16  cpu { 0xffff };
         bool    gst { false };
         bool    dir { false };
+        bool    aff { false };      // Route to the CPU of the acknowledging EC
 
         static Interrupt int_table[SPI_NUM];
 
@@ -50,7 +54,9 @@ class Interrupt : private Intid
 
         static void conf_sgi (unsigned, bool);
         static void conf_ppi (unsigned, bool, bool);
-        static void conf_spi (unsigned, unsigned, bool, bool, bool);
+        static void conf_spi (unsigned, unsigned, bool, bool, bool, bool = false, Vmcb * = nullptr, uint64 = 0);
+
+        static bool inject_vtimer (Vmcb *);
 
         static void send_sgi (Sgi, unsigned);
 
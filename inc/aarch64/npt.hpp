@@ -93,14 +93,53 @@ class Nptp : public Npt
         }
 
         ALWAYS_INLINE
-        inline void flush (Vmid v)
+        inline void flush (Vmid v, bool bcast)
         {
             make_current (v);
 
-            asm volatile ("dsb  ishst           ;"  // Ensure PTE writes have completed
-                          "tlbi vmalls12e1is    ;"  // Invalidate TLB
-                          "dsb  ish             ;"  // Ensure TLB invalidation completed
-                          "isb                  ;"  // Ensure subsequent instructions use new translation
-                          : : : "memory");
+            if (bcast)
+                asm volatile ("dsb  ishst           ;"  // Ensure PTE writes have completed
+                              "tlbi vmalls12e1is    ;"  // Invalidate TLB
+                              "dsb  ish             ;"  // Ensure TLB invalidation completed
+                              "isb                  ;"  // Ensure subsequent instructions use new translation
+                              : : : "memory");
+            else
+                asm volatile ("dsb  nshst           ;"  // Ensure PTE writes have completed
+                              "tlbi vmalls12e1      ;"  // Invalidate TLB
+                              "dsb  nsh             ;"  // Ensure TLB invalidation completed
+                              "isb                  ;"  // Ensure subsequent instructions use new translation
+                              : : : "memory");
+        }
+
+        ALWAYS_INLINE
+        inline void flush (Vmid v, bool bcast, uint64 ipa, unsigned o)
+        {
+            make_current (v);
+
+            if (bcast) {
+
+                asm volatile ("dsb  ishst" : : : "memory");     // Ensure PTE writes have completed
+
+                for (uint64 i = 0; i < 1ULL << o; i++)
+                    asm volatile ("tlbi ipas2e1is, %0" : : "r" ((ipa >> PAGE_BITS) + i) : "memory");
+
+                asm volatile ("dsb  ish             ;"  // Ensure stage-2 invalidation completed
+                              "tlbi vmalle1is       ;"  // Invalidate combined stage-1 entries
+                              "dsb  ish             ;"  // Ensure TLB invalidation completed
+                              "isb                  ;"  // Ensure subsequent instructions use new translation
+                              : : : "memory");
+            } else {
+
+                asm volatile ("dsb  nshst" : : : "memory");     // Ensure PTE writes have completed
+
+                for (uint64 i = 0; i < 1ULL << o; i++)
+                    asm volatile ("tlbi ipas2e1, %0" : : "r" ((ipa >> PAGE_BITS) + i) : "memory");
+
+                asm volatile ("dsb  nsh             ;"  // Ensure stage-2 invalidation completed
+                              "tlbi vmalle1         ;"  // Invalidate combined stage-1 entries
+                              "dsb  nsh             ;"  // Ensure TLB invalidation completed
+                              "isb                  ;"  // Ensure subsequent instructions use new translation
+                              : : : "memory");
+            }
         }
 };
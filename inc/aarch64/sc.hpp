@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "bits.hpp"
 #include "compiler.hpp"
 #include "kobject.hpp"
 #include "queue.hpp"
@@ -46,15 +47,27 @@ class Sc : public Kobject
         Sc *                    next                { nullptr };
 
         static unsigned const   priorities = 128;
-        static unsigned         prio_top            CPULOCAL;
+        static unsigned const   prio_bits = 8 * sizeof (mword);
         static Sc *             list[priorities]    CPULOCAL;
+        static mword            prio_map[priorities / prio_bits] CPULOCAL;
+        static mword            prio_sum            CPULOCAL;
         static Slab_cache       cache;
 
+        static_assert (priorities % prio_bits == 0 && priorities / prio_bits <= prio_bits, "Unsupported priority bitmap geometry");
+
         static struct Rq {
             Spinlock            lock;
             Sc *                queue;
         } rq CPULOCAL;
 
+        ALWAYS_INLINE
+        static inline unsigned prio_top()
+        {
+            long i = bit_scan_reverse (prio_sum);
+
+            return i < 0 ? 0 : static_cast<unsigned>(i * prio_bits + bit_scan_reverse (prio_map[i]));
+        }
+
         void ready_enqueue (uint64);
         void ready_dequeue (uint64);
 
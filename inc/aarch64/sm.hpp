@@ -30,11 +30,13 @@
 class Sm : public Kobject, public Queue<Ec>
 {
     private:
-        mword                   counter             { 0 };
+        mword                   counter             { 0 };      // Signalled members for an event set
+        Sm *                    evs                 { nullptr };// Event set this member signals
+        mword                   evt                 { 0 };      // Member bit in that set
 
         static Slab_cache       cache;
 
-        Sm (mword, unsigned);
+        Sm (mword, unsigned, bool);
 
         ALWAYS_INLINE
         static inline void *operator new (size_t) { return cache.alloc(); }
@@ -44,23 +46,36 @@ class Sm : public Kobject, public Queue<Ec>
 
     public:
         unsigned const spi;
+        bool const set;
 
-        static Sm *create (mword c, unsigned i = ~0U)
+        static Sm *create (mword c, unsigned i = ~0U, bool s = false)
         {
-            Sm *ptr (new Sm (c, i));
+            Sm *ptr (new Sm (c, i, s));
             return ptr;
         }
 
         void destroy() { delete this; }
 
         ALWAYS_INLINE
-        inline void dn (bool zero, uint64 t)
+        inline void dn (bool zero, uint64 t, uint64 s = 0)
         {
             Ec *ec = Ec::current;
 
             {   Lock_guard <Spinlock> guard (lock);
 
-                if (counter) {
+                // A bound member is only acknowledged, its set does the blocking
+                if (EXPECT_FALSE (evs))
+                    return;
+
+                if (EXPECT_FALSE (set)) {
+                    if (counter) {
+                        ec->sys_regs()->set_p1 (counter);
+                        counter = 0;
+                        return;
+                    }
+                }
+
+                else if (counter) {
                     counter = zero ? 0 : counter - 1;
                     return;
                 }
@@ -69,7 +84,7 @@ class Sm : public Kobject, public Queue<Ec>
             }
 
             if (ec->block_sc()) {
-                ec->set_timeout (t, this);
+                ec->set_timeout (t, s, this);
                 Sc::schedule (true);
             }
         }
@@ -77,6 +92,13 @@ class Sm : public Kobject, public Queue<Ec>
         ALWAYS_INLINE
         inline bool up()
         {
+            Sm *s = ACCESS_ONCE (evs);
+
+            if (EXPECT_FALSE (s)) {
+                s->signal (ACCESS_ONCE (evt));
+                return true;
+            }
+
             Ec *ec;
 
             {   Lock_guard <Spinlock> guard (lock);
@@ -108,4 +130,26 @@ class Sm : public Kobject, public Queue<Ec>
 
             ec->release (Ec::sys_finish<Sys_regs::TIMEOUT>);
         }
+
+        // Mark members in an event set and hand them to at most one waiter
+        ALWAYS_INLINE
+        inline void signal (mword m)
+        {
+            Ec *ec;
+
+            {   Lock_guard <Spinlock> guard (lock);
+
+                counter |= m;
+
+                if (!dequeue (ec = head()))
+                    return;
+
+                ec->sys_regs()->set_p1 (counter);
+                counter = 0;
+            }
+
+            ec->release (Ec::sys_finish<Sys_regs::SUCCESS, true>);
+        }
+
+        bool bind (Sm *, unsigned);
 };
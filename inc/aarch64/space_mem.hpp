@@ -22,6 +22,8 @@
 #pragma once
 
 #include "compiler.hpp"
+#include "cpu.hpp"
+#include "cpuset.hpp"
 #include "dpt.hpp"
 #include "hpt.hpp"
 #include "npt.hpp"
@@ -37,8 +39,22 @@ class Space_mem : public Space
         Nptp    mem_gst;
         Dptp    dma_hst;
         Dptp    dma_gst;
+        Cpuset  cpus_hst;       // CPUs that have used mem_hst
+        Cpuset  cpus_gst;       // CPUs that have used mem_gst
+
+        bool bcast (Space::Index);
 
     public:
+        // Invalidating more pages than this takes a full flush
+        static unsigned const tlb_max = 32;
+
+        ALWAYS_INLINE
+        static inline void track (Cpuset &c)
+        {
+            if (EXPECT_FALSE (!c.chk (Cpu::id)))
+                c.set (Cpu::id);
+        }
+
         ALWAYS_INLINE
         inline Space_mem()
         {
@@ -52,12 +68,13 @@ class Space_mem : public Space
         inline auto ptab_hst() { return dma_hst.init_root(); }
         inline auto ptab_gst() { return dma_gst.init_root(); }
 
-        inline void make_current_hst() { mem_hst.make_current (id_hst); }
-        inline void make_current_gst() { mem_gst.make_current (id_gst); }
+        inline void make_current_hst() { track (cpus_hst); mem_hst.make_current (id_hst); }
+        inline void make_current_gst() { track (cpus_gst); mem_gst.make_current (id_gst); }
 
         Paging::Permissions lookup (uint64 v, uint64 &p, unsigned &o, Memtype::Index &mt, Memtype::Shareability &sh) { return mem_hst.lookup (v, p, o, mt, sh); }
 
         void update (uint64, uint64, unsigned, Paging::Permissions, Memtype::Index, Memtype::Shareability, Space::Index = Space::Index::MEM_HST);
 
         void flush (Space::Index);
+        void flush (Space::Index, uint64, unsigned);
 };
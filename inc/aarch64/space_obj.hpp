@@ -35,11 +35,13 @@ class Space_obj : public Space
 
         Capability *root { nullptr };
 
-        Capability *walk (unsigned long);
+        Capability *walk (unsigned long, bool);
 
     public:
         static uint64 const num = 1ULL << lev * bpl;
 
+        mword gen { 0 };        // Incremented whenever a capability is replaced
+
         Capability lookup (unsigned long);
 
         void update (unsigned long, Capability);
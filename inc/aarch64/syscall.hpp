@@ -105,6 +105,8 @@ class Sys_create_sm : public Sys_regs
         unsigned long own() const { return r[1]; }
 
         mword cnt() const { return r[2]; }
+
+        bool set() const { return flags() & 0x2; }
 };
 
 class Sys_ctrl_pd : public Sys_regs
@@ -135,6 +137,14 @@ class Sys_ctrl_ec : public Sys_regs
 {
     public:
         unsigned long ec() const { return r[0] >> 8; }
+
+        bool fpu() const { return flags() & 0x1; }
+
+        bool vtm() const { return flags() & 0x2; }
+
+        uint64 tpl() const { return r[1]; }
+
+        void set_fpu (unsigned traps, unsigned loads) { r[1] = traps; r[2] = loads; }
 };
 
 class Sys_ctrl_sc : public Sys_regs
@@ -164,7 +174,15 @@ class Sys_ctrl_sm : public Sys_regs
 
         bool zc() const { return flags() & 0x2; }
 
+        bool bind() const { return flags() & 0x4; }
+
+        unsigned long evs() const { return r[1]; }
+
+        unsigned evt() const { return static_cast<unsigned>(r[2]); }
+
         uint64 time_ticks() const { return r[1]; }
+
+        uint64 slack_ticks() const { return flags() & 0x8 ? r[2] : 0; }
 };
 
 class Sys_ctrl_hw : public Sys_regs
@@ -190,11 +208,19 @@ class Sys_assign_int : public Sys_regs
 
         bool trg() const { return flags() & 0x2; }
 
+        bool aff() const { return flags() & 0x4; }
+
         bool gst() const { return flags() & 0x8; }
 
+        bool inj() const { return flags() & 0x10; }
+
         unsigned long sm() const { return r[0] >> 8; }
 
         unsigned cpu() const { return unsigned (r[1]); }
+
+        unsigned long ec() const { return r[2]; }
+
+        uint64 tpl() const { return r[3]; }
 };
 
 class Sys_assign_dev : public Sys_regs
@@ -18,30 +18,57 @@
 
 #pragma once
 
+#include "bits.hpp"
 #include "compiler.hpp"
 #include "types.hpp"
 
+/*
+ * Timeouts are kept in a per-CPU hierarchical timing wheel, see the x86
+ * variant. The generic timer runs much slower than the TSC, so the wheel
+ * uses a finer tick. Slack is given in counter ticks.
+ */
 class Timeout
 {
     private:
         uint64              time            { 0 };
         Timeout *           prev            { nullptr };
         Timeout *           next            { nullptr };
+        Timeout **          head            { nullptr };
+        uint64              slack           { 0 };
+
+        static unsigned const tick   = 4;
+        static unsigned const bits   = bit_scan_reverse (8 * sizeof (mword));
+        static unsigned const slots  = 1U << bits;
+        static unsigned const levels = 5;
 
-        static Timeout *    list            CPULOCAL;
+        static Timeout **   wheel           CPULOCAL;
+        static Timeout *    far             CPULOCAL;
+        static mword        map[levels]     CPULOCAL;
+        static uint64       base            CPULOCAL;
+        static uint64       dln             CPULOCAL;
 
         virtual void trigger() = 0;
 
+        void insert (Timeout **);
+        void place();
+
+        static void collect (Timeout *&, Timeout *&);
+        static void program (uint64);
+        static uint64 expiry (Timeout *);
+        static uint64 earliest();
+        static Timeout *due (uint64);
+
     public:
         // Enforce a constructor for CPU-local timeouts
         ALWAYS_INLINE
         inline Timeout() {}
 
         ALWAYS_INLINE
-        inline bool active() const { return prev || list == this; }
+        inline bool active() const { return head; }
 
-        void enqueue (uint64);
+        void enqueue (uint64, uint64 = 0);
         uint64 dequeue();
 
+        static void init();
         static void check();
 };
@@ -105,9 +105,35 @@ class Utcb
         ALWAYS_INLINE
         static inline void operator delete (void *ptr) { Buddy::allocator.free (reinterpret_cast<mword>(ptr)); }
 
+        // Short messages use a word loop, longer ones move eight words per iteration with register pairs
         inline void copy (Utcb *dst, Mtd_user mtd)
         {
-            for (unsigned i = 0; i < mtd.count(); i++)
+            unsigned i = 0, n = mtd.count();
+
+            if (n >= 16) {
+
+                mword const *s = mr;
+                mword *d = dst->mr, c = n / 8;
+                uint64 t0, t1, t2, t3, t4, t5, t6, t7;
+
+                asm volatile ("1:  ldp  %3,  %4, [%1, #0]   ;"
+                              "    ldp  %5,  %6, [%1, #16]  ;"
+                              "    ldp  %7,  %8, [%1, #32]  ;"
+                              "    ldp  %9, %10, [%1, #48]  ;"
+                              "    add  %1,  %1, #64        ;"
+                              "    stp  %3,  %4, [%0, #0]   ;"
+                              "    stp  %5,  %6, [%0, #16]  ;"
+                              "    stp  %7,  %8, [%0, #32]  ;"
+                              "    stp  %9, %10, [%0, #48]  ;"
+                              "    add  %0,  %0, #64        ;"
+                              "    subs %2,  %2, #1         ;"
+                              "    b.ne 1b                  ;"
+                              : "+r" (d), "+r" (s), "+r" (c), "=&r" (t0), "=&r" (t1), "=&r" (t2), "=&r" (t3), "=&r" (t4), "=&r" (t5), "=&r" (t6), "=&r" (t7) : : "cc", "memory");
+
+                i = n & ~7U;
+            }
+
+            for (; i < n; i++)
                 dst->mr[i] = mr[i];
         }
 
@@ -135,14 +135,21 @@ class Vmcb
             uint32  hcr         { 1 };          // Hypervisor Control Register
         } gic;
 
-        static Vmcb const *current CPULOCAL;
+        uint64      vtm         { 0 };          // List register template for the virtual timer, injected by the kernel if set
+
+        bool        dirty       { true };       // EL1 or vGIC state changed since it was last loaded or saved
+
+        static Vmcb const *current  CPULOCAL;   // Owner of the EL1 and vGIC state
+        static bool        active   CPULOCAL;   // Guest controls of the owner enabled
 
         static void init();
         static void load_hst();
 
-        void load_gst() const;
+        void load_gst();
         void save_gst();
 
+        bool inject (uint64, unsigned);
+
         ALWAYS_INLINE
         static inline void *operator new (size_t) { return Buddy::allocator.alloc (0); }
 
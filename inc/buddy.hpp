@@ -23,10 +23,12 @@
 
 #include "arch.hpp"
 #include "compiler.hpp"
+#include "config.hpp"
 #include "extern.hpp"
 #include "memory.hpp"
 #include "spinlock.hpp"
 #include "types.hpp"
+#include "util.hpp"
 
 class Buddy
 {
@@ -47,15 +49,46 @@ class Buddy
 
         };
 
+        /*
+         * CPU-local cache of free blocks for small orders
+         */
+        class Pcp
+        {
+            public:
+                Block *         head[4];
+                unsigned        count[4];
+                Block *         zero;           // Pre-zeroed order-0 blocks
+                unsigned        count_zero;
+        };
+
         Spinlock        lock;
         unsigned long   min_idx;
         unsigned long   max_idx;
         mword           base;
         Block *         index;
         Block *         head;
+        Pcp             pcp[NUM_CPU];
+        unsigned        pcp_high;       // High-water mark (pages per order and CPU)
 
         static uint16 const order = PTE_BPL + 1;
 
+        static uint16 const pcp_order = sizeof (Pcp::head) / sizeof (*Pcp::head);
+
+        static unsigned const pcp_max = 16;     // Upper bound for pcp_high
+
+        static unsigned const pcp_share = 16;   // All CPU-local caches together hold at most 1/pcp_share of the mempool
+
+        ALWAYS_INLINE
+        inline unsigned pcp_batch (uint16 o) const { return max (pcp_high >> o >> 1, 1U); }
+
+        Block *alloc_block (uint16);
+
+        void free_block (Block *);
+
+        void drain (Pcp *);
+
+        Pcp *local();
+
         ALWAYS_INLINE
         inline unsigned long block_to_index (Block *b)
         {
@@ -108,6 +141,8 @@ class Buddy
 
         void free (mword);
 
+        void fill_zero();
+
         ALWAYS_INLINE
         static inline void *phys_to_ptr (Paddr phys)
         {
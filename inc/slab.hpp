@@ -22,9 +22,12 @@
 #pragma once
 
 #include "buddy.hpp"
+#include "config.hpp"
+#include "cpu.hpp"
 #include "initprio.hpp"
 
 class Slab;
+class Slab_mag;
 
 class Slab_cache
 {
@@ -32,22 +35,59 @@ class Slab_cache
         Spinlock    lock;
         Slab *      curr    { nullptr };
         Slab *      head    { nullptr };
+        Slab_mag *  mag[NUM_CPU] { };
 
         /*
          * Back end allocator
          */
         void grow();
 
+        /*
+         * Depot (requires lock)
+         */
+        void *depot_alloc();
+        void depot_free (void *);
+
+        /*
+         * Front end (CPU-local)
+         */
+        Slab_mag *magazine (bool);
+
     public:
+        char const * const  name;   // Name of the cache
         size_t const        size;   // Size of an element
         size_t const        buff;   // Size of an element buffer (includes Slab_elem)
         unsigned long const elem;   // Number of elements per slab
+        Slab_cache *        link;   // Next cache
+
+        static Slab_cache * list;
 
-        Slab_cache (size_t, size_t);
+        Slab_cache (char const *, size_t, size_t);
 
         void *alloc();
 
         void free (void *);
+
+        ALWAYS_INLINE
+        inline Slab_mag *local() const { return mag[Cpu::id]; }
+};
+
+class Slab_mag
+{
+    public:
+        static unsigned const batch = 8;    // Elements moved between magazine and depot at once
+
+        static Slab_cache cache;
+
+        unsigned    count   { 0 };
+        unsigned    hit     { 0 };          // Allocations served by the magazine
+        unsigned    miss    { 0 };          // Allocations that required a refill
+        unsigned    refill  { 0 };          // Elements fetched from the depot
+        unsigned    drain   { 0 };          // Elements returned to the depot
+        void *      elem[2 * batch];
+
+        ALWAYS_INLINE
+        static inline void *operator new (size_t) { return cache.alloc(); }
 };
 
 class Slab_elem
@@ -36,10 +36,18 @@ inline mword stackptr()
     return rsp;
 }
 
+/*
+ * CPU-local data is accessible once we run on the CPU-local stack
+ */
+inline bool cpulocal()
+{
+    return ((stackptr() - 1) & ~PAGE_MASK) == CPU_LOCAL_STCK;
+}
+
 #define trace(T,format,...)                         \
 do {                                                \
     if (EXPECT_FALSE ((trace_mask & (T)) == (T)))   \
-        Console::print ("[%2ld] " format, static_cast<long>(((stackptr() - 1) & ~PAGE_MASK) == CPU_LOCAL_STCK ? ACCESS_ONCE (Cpu::id) : ~0UL), ## __VA_ARGS__);   \
+        Console::print ("[%2ld] " format, static_cast<long>(cpulocal() ? ACCESS_ONCE (Cpu::id) : ~0UL), ## __VA_ARGS__);   \
 } while (0)
 
 /*
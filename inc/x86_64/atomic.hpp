@@ -27,7 +27,7 @@ class Atomic : public Atomic_base
         static inline bool test_set_bit (T &val, unsigned long bit)
         {
             bool ret;
-            asm volatile ("lock; bts%z1 %2, %1; setc %0" : "=q" (ret), "+m" (val) : "ir" (bit) : "cc");
+            asm volatile ("lock; bts%z1 %2, %1; setc %0" : "=q" (ret), "+m" (val) : "ir" (static_cast<T>(bit)) : "cc");
             return ret;
         }
 
@@ -35,7 +35,7 @@ class Atomic : public Atomic_base
         static inline bool test_clr_bit (T &val, unsigned long bit)
         {
             bool ret;
-            asm volatile ("lock; btr%z1 %2, %1; setc %0" : "=q" (ret), "+m" (val) : "ir" (bit) : "cc");
+            asm volatile ("lock; btr%z1 %2, %1; setc %0" : "=q" (ret), "+m" (val) : "ir" (static_cast<T>(bit)) : "cc");
             return ret;
         }
 };
@@ -0,0 +1,63 @@
+/*
+ * Channel
+ *
+ * Copyright (C) 2019 Udo Steinberg, BedRock Systems, Inc.
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include "ec.hpp"
+
+/*
+ * Bounded message ring between ECs on any CPUs. Senders reserve slots
+ * lock-free, receivers are serialized by the object lock. A sender only
+ * takes the lock and wakes receivers when one of them is blocked.
+ */
+class Ch : public Kobject, public Queue<Ec>
+{
+    private:
+        struct Slot
+        {
+            mword   seq;            // Ring position for which the slot is free or full
+            mword   msg;
+        };
+
+        Slot *      ring;
+        mword const mask;
+        mword       wr;             // Next slot to reserve (senders)
+        mword       rd;             // Next slot to consume (receivers)
+        bool        sleep;          // Receivers blocked
+
+        static Slab_cache cache;
+
+        bool put (mword);
+
+    public:
+        static unsigned const max = 4;      // Largest ring order (pages)
+
+        Ch (Pd *, mword, unsigned);
+        ~Ch();
+
+        mword send (mword const *, mword);
+        mword recv (mword *, mword);
+
+        void wait();
+        void wake();
+
+        ALWAYS_INLINE
+        static inline void *operator new (size_t) { return cache.alloc(); }
+
+        ALWAYS_INLINE
+        static inline void operator delete (void *ptr) { cache.free (ptr); }
+};
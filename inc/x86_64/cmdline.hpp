@@ -36,6 +36,7 @@ class Cmdline
         static char *get_arg (char **line);
 
     public:
+        static bool bench;
         static bool iommu;
         static bool keyb;
         static bool serial;
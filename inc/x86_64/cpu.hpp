@@ -61,6 +61,7 @@ class Cpu
             FEAT_PCID           = 49,
             FEAT_TSC_DEADLINE   = 56,
             FEAT_SMEP           = 103,
+            FEAT_ERMS           = 105,
             FEAT_1GB_PAGES      = 154,
             FEAT_CMP_LEGACY     = 161,
             FEAT_SVM            = 162,
@@ -104,6 +105,7 @@ class Cpu
             CR4_VMXE        = 1UL << 13,        // 0x2000
             CR4_SMXE        = 1UL << 14,        // 0x4000
             CR4_PCIDE       = 1UL << 17,        // 0x20000
+            CR4_OSXSAVE     = 1UL << 18,        // 0x40000
             CR4_SMEP        = 1UL << 20,        // 0x100000
         };
 
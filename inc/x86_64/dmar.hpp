@@ -21,6 +21,7 @@
 #pragma once
 
 #include "list.hpp"
+#include "lock_guard.hpp"
 #include "lowlevel.hpp"
 #include "slab.hpp"
 
@@ -50,7 +51,7 @@ class Dmar_qi_tlb : public Dmar_qi
 class Dmar_qi_iec : public Dmar_qi
 {
     public:
-        Dmar_qi_iec() : Dmar_qi (0x4 | 1UL << 4) {}
+        Dmar_qi_iec (unsigned i = 0) : Dmar_qi (0x4 | 1UL << 4 | static_cast<uint64>(i) << 32) {}
 };
 
 class Dmar_ctx
@@ -93,10 +94,12 @@ class Dmar : public List<Dmar>
         uint64              ecap;
         Dmar_qi *           invq;
         unsigned            invq_idx;
+        Spinlock            invq_lock;
 
         static Dmar_ctx *   ctx;
         static Dmar_irt *   irt;
         static uint32       gcmd;
+        static bool         pst;
 
         static Dmar *       list;
         static Slab_cache   cache;
@@ -153,6 +156,9 @@ class Dmar : public List<Dmar>
         ALWAYS_INLINE
         inline unsigned qi() const { return static_cast<unsigned>(ecap) & 0x2; }
 
+        ALWAYS_INLINE
+        inline unsigned pi() const { return static_cast<unsigned>(cap >> 59) & 0x1; }
+
         template <typename T>
         ALWAYS_INLINE
         inline T read (Reg reg)
@@ -215,6 +221,7 @@ class Dmar : public List<Dmar>
         inline void flush_ctx()
         {
             if (qi()) {
+                Lock_guard <Spinlock> guard (invq_lock);
                 qi_submit (Dmar_qi_ctx());
                 qi_submit (Dmar_qi_tlb());
                 qi_wait();
@@ -252,9 +259,31 @@ class Dmar : public List<Dmar>
             irt[i].set (1ULL << 18 | rid, static_cast<uint64>(cpu) << 40 | vec << 16 | trg << 4 | 1);
         }
 
+        // Posted format: deliver the vector into the descriptor at pda
+        ALWAYS_INLINE
+        static inline void set_pirt (unsigned i, unsigned rid, uint64 pda, unsigned vec)
+        {
+            irt[i].set (pda >> 32 << 32 | 1ULL << 18 | rid, (pda & ~0x3fULL) << 32 | vec << 16 | 1ULL << 15 | 1);
+        }
+
+        // Drop cached copies of a modified remapping entry
+        ALWAYS_INLINE
+        static inline void flush_irt (unsigned i)
+        {
+            for (Dmar *dmar = list; dmar; dmar = dmar->next)
+                if (dmar->qi()) {
+                    Lock_guard <Spinlock> guard (dmar->invq_lock);
+                    dmar->qi_submit (Dmar_qi_iec (i));
+                    dmar->qi_wait();
+                }
+        }
+
         ALWAYS_INLINE
         static bool ire() { return gcmd & GCMD_IRE; }
 
+        ALWAYS_INLINE
+        static bool pie() { return pst && ire(); }
+
         void assign (unsigned long, Pd *);
 
         REGPARM (1)
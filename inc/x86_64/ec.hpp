@@ -36,6 +36,7 @@ class Utcb;
 class Ec : public Kobject, public Refcount, public Queue<Sc>
 {
     friend class Queue<Ec>;
+    friend class Sm;
 
     private:
         void        (*cont)() ALIGNED (16);
@@ -47,6 +48,10 @@ class Ec : public Kobject, public Refcount, public Queue<Sc>
         Ec *        prev;
         Ec *        next;
         Fpu *       fpu;
+        unsigned    fpu_traps;      // FPU switches on first use (#NM)
+        unsigned    fpu_loads;      // FPU switches ahead of use
+        unsigned    fpu_score;
+        Window      win;            // Memory lent during a bulk call
         union {
             struct {
                 uint16  cpu;
@@ -59,6 +64,9 @@ class Ec : public Kobject, public Refcount, public Queue<Sc>
 
         static Slab_cache cache;
 
+        // Each #NM raises the score, each switch to this EC without owning the FPU lowers it
+        static unsigned const fpu_boost = 16, fpu_eager = 16, fpu_limit = 64;
+
         REGPARM (1)
         static void handle_exc (Exc_regs *) asm ("exc_handler");
 
@@ -87,6 +95,8 @@ class Ec : public Kobject, public Refcount, public Queue<Sc>
         NORETURN
         static inline void svm_invlpg();
 
+        static inline void svm_xsetbv();
+
         NORETURN
         static inline void vmx_exception();
 
@@ -99,6 +109,8 @@ class Ec : public Kobject, public Refcount, public Queue<Sc>
         NORETURN
         static inline void vmx_cr();
 
+        static inline void vmx_xsetbv();
+
         static bool fixup (mword &);
 
         NOINLINE
@@ -136,6 +148,7 @@ class Ec : public Kobject, public Refcount, public Queue<Sc>
 
         void load_fpu();
         void save_fpu();
+        void adapt_fpu();
 
         void transfer_fpu (Ec *);
 
@@ -146,6 +159,8 @@ class Ec : public Kobject, public Refcount, public Queue<Sc>
         Ec (Pd *, void (*)(), unsigned);
         Ec (Pd *, mword, Pd *, void (*)(), unsigned, unsigned, mword, mword);
 
+        ~Ec();
+
         ALWAYS_INLINE
         inline void add_tsc_offset (uint64 tsc)
         {
@@ -156,10 +171,13 @@ class Ec : public Kobject, public Refcount, public Queue<Sc>
         inline bool blocked() const { return next || !cont; }
 
         ALWAYS_INLINE
-        inline void set_timeout (uint64 t, Sm *s)
+        inline Pid *pid() const { return utcb ? nullptr : regs.pid; }
+
+        ALWAYS_INLINE
+        inline void set_timeout (uint64 t, uint64 l, Sm *s)
         {
             if (EXPECT_FALSE (t))
-                timeout.enqueue (t, s);
+                timeout.enqueue (t, l, s);
         }
 
         ALWAYS_INLINE
@@ -172,6 +190,9 @@ class Ec : public Kobject, public Refcount, public Queue<Sc>
         ALWAYS_INLINE NORETURN
         inline void make_current()
         {
+            if (EXPECT_FALSE (fpu_score) && fpowner != this)
+                adapt_fpu();
+
             current = this;
 
             Tss::run.sp0 = reinterpret_cast<mword>(exc_regs() + 1);
@@ -28,19 +28,101 @@
 class Fpu
 {
     private:
-        char data[512];
+        // Legacy region
+        uint16  fcw ALIGNED (64);
+        uint16  fsw;
+        uint8   ftw;
+        uint8   res;
+        uint16  fop;
+        uint64  fip;
+        uint64  fdp;
+        uint32  mxcsr;
+        uint32  mxcsr_mask;
+        uint8   regs[480];
+
+        // XSAVE header, followed by the extended region
+        uint64  xstate_bv;
+        uint64  xcomp_bv;
+        uint64  rsvd[6];
 
         static Slab_cache cache;
+        static Fpu empty;
+
+        static size_t probe();
 
     public:
+        enum Mode
+        {
+            FXSR,
+            XSAVE,
+            XSAVEOPT,
+            XSAVES,
+        };
+
+        enum
+        {
+            XCR0_X87        = 1ULL << 0,
+            XCR0_SSE        = 1ULL << 1,
+            XCR0_AVX        = 1ULL << 2,
+            XCR0_AVX512     = 7ULL << 5,    // Opmask, ZMM_Hi256, Hi16_ZMM
+        };
+
+        static Mode     mode;
+        static uint64   xcr0;               // Components managed for user ECs
+        static uint64   xcr     CPULOCAL;   // Current value of XCR0
+
+        ALWAYS_INLINE
+        inline Fpu() : fcw (0x37f), fsw (0), ftw (0), res (0), fop (0), fip (0), fdp (0), mxcsr (0x1f80), mxcsr_mask (0), regs(),
+                       xstate_bv (0), xcomp_bv (mode == XSAVES ? 1ULL << 63 | xcr0 : 0), rsvd() {}
+
         ALWAYS_INLINE
-        inline void save() { asm volatile ("fxsave %0" : "=m" (*data)); }
+        inline void save()
+        {
+            switch (mode) {
+                case XSAVES:   asm volatile ("xsaves %0"   : "+m" (*this) : "a" (~0U), "d" (~0U)); break;
+                case XSAVEOPT: asm volatile ("xsaveopt %0" : "+m" (*this) : "a" (~0U), "d" (~0U)); break;
+                case XSAVE:    asm volatile ("xsave %0"    : "+m" (*this) : "a" (~0U), "d" (~0U)); break;
+                case FXSR:     asm volatile ("fxsave %0"   : "=m" (*this));                         break;
+            }
+        }
 
         ALWAYS_INLINE
-        inline void load() { asm volatile ("fxrstor %0" : : "m" (*data)); }
+        inline void load()
+        {
+            switch (mode) {
+                case XSAVES:   asm volatile ("xrstors %0"  : : "m" (*this), "a" (~0U), "d" (~0U)); break;
+                case XSAVEOPT:
+                case XSAVE:    asm volatile ("xrstor %0"   : : "m" (*this), "a" (~0U), "d" (~0U)); break;
+                case FXSR:     asm volatile ("fxrstor %0"  : : "m" (*this));                         break;
+            }
+        }
 
         ALWAYS_INLINE
-        static inline void init() { asm volatile ("fninit"); }
+        static inline void init() { empty.load(); }
+
+        ALWAYS_INLINE
+        static inline bool valid (uint64 val)
+        {
+            return (val & XCR0_X87) && !(val & ~xcr0) &&
+                   (!(val & XCR0_AVX)    || (val & XCR0_SSE)) &&
+                   (!(val & XCR0_AVX512) || ((val & XCR0_AVX512) == XCR0_AVX512 && (val & XCR0_AVX)));
+        }
+
+        ALWAYS_INLINE
+        static inline void set_xcr (uint64 val)
+        {
+            if (EXPECT_TRUE (xcr == val))
+                return;
+
+            asm volatile ("xsetbv" : : "a" (static_cast<uint32>(val)), "d" (static_cast<uint32>(val >> 32)), "c" (0));
+
+            if ((xcr = val) == xcr0)
+                Cpu::hazard &= ~HZD_XCR0;
+            else
+                Cpu::hazard |= HZD_XCR0;
+        }
+
+        static void setup();
 
         ALWAYS_INLINE
         static inline void enable() { asm volatile ("clts"); Cpu::hazard |= HZD_FPU; }
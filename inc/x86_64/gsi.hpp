@@ -22,8 +22,10 @@
 
 #include "assert.hpp"
 #include "config.hpp"
+#include "spinlock.hpp"
 
 class Ioapic;
+class Pid;
 class Sm;
 
 class Gsi
@@ -38,13 +40,28 @@ class Gsi
                 uint8   dlv:3, dst:1, sts:1, pol:1, irr:1, trg:1;
             };
         };
+        uint16          rid;
+        uint8           cpu;
+        bool            aff;        // Route to the CPU of the acknowledging EC
+        Pid *           pid;        // Posted to this vCPU
+        Gsi *           pin;        // Next GSI posted on the same CPU
 
         static Gsi      gsi_table[NUM_GSI];
         static unsigned irq_table[NUM_IRQ];
+        static Gsi *    pin_list[NUM_CPU];
+        static Spinlock pin_lock;
 
         static void setup();
 
-        static uint64 set (unsigned, unsigned = 0, unsigned = 0);
+        static uint64 set (unsigned, unsigned = 0, unsigned = 0, bool = false);
+
+        static void steer (unsigned, unsigned);
+
+        static void post (unsigned, Pid *, unsigned, unsigned);
+
+        static void pin_handler();
+
+        static void unpost (Gsi &);
 
         static void mask (unsigned);
         static void unmask (unsigned);
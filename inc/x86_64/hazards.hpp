@@ -23,6 +23,7 @@
 #define HZD_TR          0x4
 #define HZD_FPU         0x8
 #define HZD_RCU         0x10
+#define HZD_XCR0        0x20
 #define HZD_TSC         0x20000000
 #define HZD_STEP        0x40000000
 #define HZD_RECALL      0x80000000
@@ -33,13 +33,13 @@ class Hpt : public Pte<Hpt, mword, PTE_LEV, PTE_BPL, false>
             asm volatile ("mov %%cr3, %0; mov %0, %%cr3" : "=&r" (cr3));
         }
 
+    public:
         ALWAYS_INLINE
         static inline void flush (mword addr)
         {
             asm volatile ("invlpg %0" : : "m" (*reinterpret_cast<mword *>(addr)));
         }
 
-    public:
         static mword ord;
 
         enum
@@ -52,6 +52,7 @@ class Hpt : public Pte<Hpt, mword, PTE_LEV, PTE_BPL, false>
             HPT_D   = 1UL << 6,
             HPT_S   = 1UL << 7,
             HPT_G   = 1UL << 8,
+            HPT_L   = 1UL << 9,     // Lent through a window (ignored by hardware)
             HPT_NX  = 0,
 
             PTE_P   = HPT_P,
@@ -41,6 +41,7 @@ class Kobject : public Mdb
             SC,
             PT,
             SM,
+            CH,
         };
 
         explicit Kobject (Type t, Space *s, mword b = 0, mword a = 0) : Mdb (s, reinterpret_cast<mword>(this), b, a, free), objtype (t) {}
@@ -69,6 +69,7 @@ class Lapic
         enum Shorthand
         {
             DSH_NONE        = 0U << 18,
+            DSH_SELF        = 1U << 18,
             DSH_EXC_SELF    = 3U << 18,
         };
 
@@ -151,6 +152,12 @@ class Lapic
 
         static void send_ipi (unsigned, unsigned, Delivery_mode = DLV_FIXED, Shorthand = DSH_NONE);
 
+        ALWAYS_INLINE
+        static inline void send_self (unsigned vector)
+        {
+            send_ipi (0, vector, DLV_FIXED, DSH_SELF);
+        }
+
         REGPARM (1)
         static void lvt_vector (unsigned) asm ("lvt_vector");
 
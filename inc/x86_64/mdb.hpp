@@ -31,10 +31,22 @@ class Mdb : public Avl, public Rcu_elem
 {
     private:
         static Slab_cache   cache;
-        static Spinlock     lock;
 
         bool alive() const { return prev->next == this && next->prev == this; }
 
+        /*
+         * Each derivation tree is serialized by the tree lock of its root node
+         */
+        Mdb *root()
+        {
+            Mdb *r = this;
+
+            while (r->prnt)
+                r = r->prnt;
+
+            return r;
+        }
+
         static void free (Rcu_elem *e)
         {
             Mdb *m = static_cast<Mdb *>(e);
@@ -43,6 +55,7 @@ class Mdb : public Avl, public Rcu_elem
 
     public:
         Spinlock        node_lock;
+        Spinlock        tree_lock;
         uint16          dpth;
         Mdb *           prev;
         Mdb *           next;
@@ -88,6 +101,8 @@ class Mdb : public Avl, public Rcu_elem
         void demote_node (mword);
         bool remove_node();
 
+        static void bench();
+
         ALWAYS_INLINE
         static inline void *operator new (size_t) { return cache.alloc(); }
 
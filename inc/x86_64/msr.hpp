@@ -80,6 +80,7 @@ class Msr
 
             IA32_DS_AREA            = 0x600,
             IA32_TSC_DEADLINE       = 0x6e0,
+            IA32_XSS                = 0xda0,
             IA32_EXT_XAPIC          = 0x800,
             IA32_EFER               = 0xc0000080,
             IA32_STAR               = 0xc0000081,
@@ -36,6 +36,8 @@ class Pd : public Kobject, public Refcount, public Space_mem, public Space_pio,
         WARN_UNUSED_RESULT
         mword clamp (mword &, mword &, mword, mword, mword);
 
+        bool rev (Crd, bool);
+
     public:
         static Pd *current CPULOCAL_HOT;
         static Pd kern, root;
@@ -49,10 +51,11 @@ class Pd : public Kobject, public Refcount, public Space_mem, public Space_pio,
         {
             mword pcid = did;
 
-            if (EXPECT_FALSE (htlb.chk (Cpu::id)))
+            if (EXPECT_FALSE (htlb.chk (Cpu::id))) {
+                tlb_done[Cpu::id] = ACCESS_ONCE (tlb_seq);
                 htlb.clr (Cpu::id);
 
-            else {
+            } else {
 
                 if (EXPECT_TRUE (current == this))
                     return;
@@ -94,6 +97,11 @@ class Pd : public Kobject, public Refcount, public Space_mem, public Space_pio,
         void xlt_crd (Pd *, Crd, Crd &);
         void del_crd (Pd *, Crd, Crd &, mword = 0, mword = 0);
         void rev_crd (Crd, bool);
+        void rev_items (Xfer *, unsigned long, bool);
+
+        void lend_crd (Window &, Pd *, Crd, Crd);
+
+        static void unlend (Window &);
 
         ALWAYS_INLINE
         static inline void *operator new (size_t) { return cache.alloc(); }
@@ -0,0 +1,67 @@
+/*
+ * Posted-Interrupt Descriptor
+ *
+ * Copyright (C) 2019 Udo Steinberg, BedRock Systems, Inc.
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include "atomic.hpp"
+#include "compiler.hpp"
+#include "slab.hpp"
+
+/*
+ * Shared between the kernel, the CPU (VMX) and the IOMMU (VT-d). Whoever
+ * posts a vector sets its request bit and then the outstanding-notification
+ * bit. Only the poster that sets ON sends the notification vector NV.
+ *
+ * NV is VEC_IPI_PIN only while the vCPU is in guest mode, where the CPU
+ * processes the notification itself. At all other times it is VEC_IPI_PWK,
+ * which reaches the kernel even if another vCPU is in guest mode.
+ */
+class Pid
+{
+    private:
+        uint32  pir[8];             // Posted-interrupt requests
+        uint32  ctl;                // ON (0), SN (1), NV (16-23)
+        uint32  dst;                // Notification destination
+        uint32  res[6];
+
+        static Slab_cache cache;
+
+    public:
+        Pid (unsigned);
+
+        ALWAYS_INLINE
+        inline bool post (unsigned v)
+        {
+            Atomic::test_set_bit (pir[v / 32], v % 32);
+            return !Atomic::test_set_bit (ctl, 0);
+        }
+
+        ALWAYS_INLINE
+        inline bool pending() { return ACCESS_ONCE (ctl) & 1; }
+
+        ALWAYS_INLINE
+        inline unsigned nv() { return ACCESS_ONCE (ctl) >> 16 & 0xff; }
+
+        ALWAYS_INLINE
+        inline void set_nv (unsigned v)
+        {
+            for (uint32 o = ACCESS_ONCE (ctl); !Atomic::cmp_swap (ctl, o, (o & ~0xff0000U) | v << 16); ) ;
+        }
+
+        ALWAYS_INLINE
+        static inline void *operator new (size_t) { return cache.alloc(); }
+};
@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include "crd.hpp"
 #include "kobject.hpp"
 #include "mtd.hpp"
 
@@ -35,12 +36,20 @@ class Pt : public Kobject
         Mtd        const mtd;
         mword      const ip;
         mword      id;
+        Crd        win;         // Transfer window in the handler PD
+        bool       reg;         // Message passed in registers
 
         Pt (Pd *, mword, Ec *, Mtd, mword);
 
         ALWAYS_INLINE
         inline void set_id (mword i) { id = i; }
 
+        ALWAYS_INLINE
+        inline void set_win (Crd w) { win = w; }
+
+        ALWAYS_INLINE
+        inline void set_reg (bool r) { reg = r; }
+
         ALWAYS_INLINE
         static inline void *operator new (size_t) { return cache.alloc(); }
 
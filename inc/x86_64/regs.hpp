@@ -26,6 +26,7 @@
 #include "hazards.hpp"
 #include "types.hpp"
 
+class Pid;
 class Vmcb;
 class Vmcs;
 class Vtlb;
@@ -84,6 +85,10 @@ class Sys_regs
 
         ALWAYS_INLINE
         inline void set_sp (mword sp) { ARG_SP = sp; }
+
+        // Register-carried message words of call and reply
+        ALWAYS_INLINE
+        inline void set_msg (Sys_regs const *r) { ARG_3 = r->ARG_3; ARG_4 = r->ARG_4; ARG_5 = r->ARG_5; }
 };
 
 class Exc_regs : public Sys_regs
@@ -115,8 +120,10 @@ class Exc_regs : public Sys_regs
                 mword   dst_portal;
                 mword   nst_fault;
                 mword   nst_error;
+                Pid *   pid;
                 uint8   nst_on;
                 uint8   fpu_on;
+                uint8   pi_on;
             };
         };
 
@@ -197,6 +204,50 @@ class Exc_regs : public Sys_regs
         template <typename T> mword linear_address (mword) const;
 };
 
+/*
+ * VMCS guest-state fields that were read or written since the last VM exit.
+ * The guest cannot change them before the next VM entry, so repeated reads
+ * and writes of unchanged values need not touch the VMCS.
+ */
+class Vmcs_cache
+{
+    public:
+        enum Field
+        {
+            SEL_ES, SEL_CS, SEL_SS, SEL_DS, SEL_FS, SEL_GS, SEL_LDTR, SEL_TR,
+            LIMIT_ES, LIMIT_CS, LIMIT_SS, LIMIT_DS, LIMIT_FS, LIMIT_GS, LIMIT_LDTR, LIMIT_TR, LIMIT_GDTR, LIMIT_IDTR,
+            AR_ES, AR_CS, AR_SS, AR_DS, AR_FS, AR_GS, AR_LDTR, AR_TR,
+            BASE_ES, BASE_CS, BASE_SS, BASE_DS, BASE_FS, BASE_GS, BASE_LDTR, BASE_TR, BASE_GDTR, BASE_IDTR,
+            RSP, RIP, RFLAGS, DR7, SYSENTER_CS, SYSENTER_ESP, SYSENTER_EIP, INTR_STATE, ACTV_STATE, EFER,
+            FIELDS
+        };
+
+        uint64  vld;
+        mword   val[FIELDS];
+
+        ALWAYS_INLINE
+        inline Vmcs_cache() : vld (0) {}
+
+        ALWAYS_INLINE
+        inline void invalidate() { vld = 0; }
+
+        ALWAYS_INLINE
+        inline void invalidate (unsigned f) { vld &= ~(1ULL << f); }
+
+        // Record a value about to be written, returns whether the VMCS holds a different one
+        ALWAYS_INLINE
+        inline bool dirty (unsigned f, mword v)
+        {
+            if (vld & 1ULL << f && val[f] == v)
+                return false;
+
+            val[f] = v;
+            vld |= 1ULL << f;
+
+            return true;
+        }
+};
+
 class Cpu_regs : public Exc_regs
 {
     private:
@@ -204,7 +255,9 @@ class Cpu_regs : public Exc_regs
 
     public:
         uint64  tsc_offset;
+        uint64  xcr0;
         mword   mtd;
+        Vmcs_cache gst;
 
         ALWAYS_INLINE
         inline mword hazard() const { return hzd; }
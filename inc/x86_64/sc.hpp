@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include "bits.hpp"
 #include "compiler.hpp"
 
 class Ec;
@@ -42,6 +43,9 @@ class Sc : public Kobject
         uint64 tsc;
 
         static unsigned const priorities = 128;
+        static unsigned const prio_bits  = 8 * sizeof (mword);
+
+        static_assert (priorities % prio_bits == 0 && priorities / prio_bits <= prio_bits, "Unsupported priority bitmap geometry");
 
         static Slab_cache cache;
 
@@ -52,7 +56,17 @@ class Sc : public Kobject
 
         static Sc *list[priorities] CPULOCAL;
 
-        static unsigned prio_top CPULOCAL;
+        static mword prio_map[priorities / prio_bits] CPULOCAL;
+
+        static mword prio_sum CPULOCAL;
+
+        ALWAYS_INLINE
+        static inline unsigned prio_top()
+        {
+            long i = bit_scan_reverse (prio_sum);
+
+            return i < 0 ? 0 : static_cast<unsigned>(i * prio_bits + bit_scan_reverse (prio_map[i]));
+        }
 
         void ready_enqueue (uint64);
         void ready_dequeue (uint64);
@@ -79,6 +93,8 @@ class Sc : public Kobject
         static void rrq_handler();
         static void rke_handler();
 
+        static void bench();
+
         NORETURN
         static void schedule (bool = false);
 
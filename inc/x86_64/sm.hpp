@@ -22,25 +22,42 @@
 #pragma once
 
 #include "ec.hpp"
+#include "syscall.hpp"
 
 class Sm : public Kobject, public Queue<Ec>
 {
     private:
-        mword counter;
+        mword counter;              // Signalled members for an event set
+        Sm *  evs;                  // Event set this member signals
+        mword evt;                  // Member bit in that set
 
         static Slab_cache cache;
 
     public:
-        Sm (Pd *, mword, mword = 0);
+        bool const set;
+
+        Sm (Pd *, mword, mword = 0, bool = false);
 
         ALWAYS_INLINE
-        inline void dn (bool zero, uint64 t)
+        inline void dn (bool zero, uint64 t, uint64 s = 0)
         {
             Ec *ec = Ec::current;
 
             {   Lock_guard <Spinlock> guard (lock);
 
-                if (counter) {
+                // A bound member is only acknowledged, its set does the blocking
+                if (EXPECT_FALSE (evs))
+                    return;
+
+                if (EXPECT_FALSE (set)) {
+                    if (counter) {
+                        static_cast<Sys_sm_ctrl *>(ec->sys_regs())->set_evt (counter);
+                        counter = 0;
+                        return;
+                    }
+                }
+
+                else if (counter) {
                     counter = zero ? 0 : counter - 1;
                     return;
                 }
@@ -48,7 +65,7 @@ class Sm : public Kobject, public Queue<Ec>
                 enqueue (ec);
             }
 
-            ec->set_timeout (t, this);
+            ec->set_timeout (t, s, this);
 
             ec->block_sc();
         }
@@ -56,6 +73,13 @@ class Sm : public Kobject, public Queue<Ec>
         ALWAYS_INLINE
         inline void up()
         {
+            Sm *s = ACCESS_ONCE (evs);
+
+            if (EXPECT_FALSE (s)) {
+                s->signal (ACCESS_ONCE (evt));
+                return;
+            }
+
             Ec *ec;
 
             {   Lock_guard <Spinlock> guard (lock);
@@ -81,6 +105,28 @@ class Sm : public Kobject, public Queue<Ec>
             ec->release (Ec::sys_finish<Sys_regs::COM_TIM>);
         }
 
+        // Mark members in an event set and hand them to at most one waiter
+        ALWAYS_INLINE
+        inline void signal (mword m)
+        {
+            Ec *ec;
+
+            {   Lock_guard <Spinlock> guard (lock);
+
+                counter |= m;
+
+                if (!dequeue (ec = head()))
+                    return;
+
+                static_cast<Sys_sm_ctrl *>(ec->sys_regs())->set_evt (counter);
+                counter = 0;
+            }
+
+            ec->release (Ec::sys_finish<Sys_regs::SUCCESS, true>);
+        }
+
+        bool bind (Sm *, unsigned);
+
         ALWAYS_INLINE
         static inline void *operator new (size_t) { return cache.alloc(); }
 
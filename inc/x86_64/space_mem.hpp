@@ -26,10 +26,60 @@
 #include "dpt.hpp"
 #include "ept.hpp"
 #include "hpt.hpp"
+#include "memory.hpp"
 #include "space.hpp"
+#include "spinlock.hpp"
+
+class Space_mem;
+
+/*
+ * Pages of one space mapped into another for the duration of a portal call.
+ * Windows bypass the mapping database. The lending space keeps track of them
+ * instead, so that revoking the underlying memory also closes the window.
+ */
+class Window
+{
+    friend class Space_mem;
+
+    private:
+        Window *    next;
+        Space_mem * src;
+        Space_mem * dst;
+        mword       sb, db, ord;                // Page numbers and order
+
+    public:
+        static unsigned const max = 10;         // Largest window order
+
+        ALWAYS_INLINE
+        inline Window() : next (nullptr), src (nullptr), dst (nullptr), sb (0), db (0), ord (0) {}
+
+        ALWAYS_INLINE
+        inline bool active() { return ACCESS_ONCE (src); }
+};
 
 class Space_mem : public Space
 {
+    private:
+        static unsigned const tlb_slots = 8;
+
+        Spinlock    tlb_lock;
+        mword       tlb_rng[tlb_slots];     // Revoked range: base | order
+
+        Spinlock    win_lock;
+        Window *    win;                    // Windows lent from this space
+
+        Spinlock    hpt_lock;               // Orders delegations against windows lent into this space
+
+        void tlb_add (mword, mword);
+
+        // Order of the page table entries that map a range of order o
+        ALWAYS_INLINE
+        static inline mword tlb_ord (mword o) { return min (o, Hpt::ord) / PTE_BPL * PTE_BPL; }
+
+        void map (mword, Paddr, mword);
+        void unmap (Window &);
+        void close (mword, mword);
+
     public:
         Hpt loc[NUM_CPU];
         Hpt hpt;
@@ -45,10 +95,18 @@ class Space_mem : public Space
         Cpuset htlb;
         Cpuset gtlb;
 
+        unsigned tlb_seq;                   // Ranges revoked
+        unsigned tlb_done[NUM_CPU];         // Ranges flushed per CPU
+
         static unsigned did_ctr;
+        static unsigned tlb_gen;
+        static unsigned tlb_ack CPULOCAL;
+
+        // Invalidating more TLB entries than this takes a full flush
+        static unsigned const tlb_max = 32;
 
         ALWAYS_INLINE
-        inline Space_mem() : did (Atomic::add (did_ctr, 1U)) {}
+        inline Space_mem() : win (nullptr), did (Atomic::add (did_ctr, 1U)), tlb_seq (0), tlb_done() {}
 
         ALWAYS_INLINE
         inline size_t lookup (mword virt, Paddr &phys)
@@ -75,6 +133,18 @@ class Space_mem : public Space
 
         void update (Mdb *, mword = 0);
 
+        bool tlb_flush (unsigned);
+
+        void lend (Window &, Space_mem *, mword, mword, mword, mword);
+
+        static bool close (Window &);
+
+        ALWAYS_INLINE
+        static inline unsigned remote_ack (unsigned c)
+        {
+            return *reinterpret_cast<volatile unsigned *>(reinterpret_cast<mword>(&tlb_ack) - CPU_LOCAL_DATA + HV_GLOBAL_CPUS + c * PAGE_SIZE);
+        }
+
         static void shootdown();
 
         void init (unsigned);
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include "atomic.hpp"
 #include "compiler.hpp"
 #include "types.hpp"
 
@@ -45,6 +46,14 @@ class Spinlock
                           : "+Q" (tmp), "+m" (val) : : "memory");
         }
 
+        ALWAYS_INLINE
+        inline bool try_lock()
+        {
+            uint16 tmp = val;
+
+            return static_cast<uint8>(tmp) == tmp >> 8 && Atomic::cmp_swap (val, tmp, static_cast<uint16>(tmp + 0x100));
+        }
+
         ALWAYS_INLINE
         inline void unlock()
         {
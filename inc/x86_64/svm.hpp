@@ -95,6 +95,7 @@ class Vmcb
             CPU_VMSAVE      = 1ul << 3,
             CPU_CLGI        = 1ul << 5,
             CPU_SKINIT      = 1ul << 6,
+            CPU_XSETBV      = 1ul << 13,
         };
 
         static mword const force_ctrl0 =    CPU_INTR    |
@@ -109,7 +110,8 @@ class Vmcb
         static mword const force_ctrl1 =    CPU_VMLOAD  |
                                             CPU_VMSAVE  |
                                             CPU_CLGI    |
-                                            CPU_SKINIT;
+                                            CPU_SKINIT  |
+                                            CPU_XSETBV;
 
         ALWAYS_INLINE
         static inline void *operator new (size_t)
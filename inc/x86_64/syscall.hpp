@@ -30,11 +30,24 @@ class Sys_call : public Sys_regs
         {
             DISABLE_BLOCKING    = 1ul << 0,
             DISABLE_DONATION    = 1ul << 1,
-            DISABLE_REPLYCAP    = 1ul << 2
+            DISABLE_REPLYCAP    = 1ul << 2,
+            BULK_TRANSFER       = 1ul << 3
         };
 
         ALWAYS_INLINE
         inline unsigned long pt() const { return ARG_1 >> 8; }
+
+        ALWAYS_INLINE
+        inline Crd bulk() const { return Crd (ARG_2); }
+};
+
+class Sys_reply : public Sys_regs
+{
+    public:
+        enum
+        {
+            REG_MESSAGE         = 1ul << 0
+        };
 };
 
 class Sys_create_pd : public Sys_regs
@@ -118,6 +131,12 @@ class Sys_create_sm : public Sys_regs
 
         ALWAYS_INLINE
         inline mword cnt() const { return ARG_3; }
+
+        ALWAYS_INLINE
+        inline bool ch() const { return flags() & 0x1; }
+
+        ALWAYS_INLINE
+        inline bool set() const { return flags() & 0x2; }
 };
 
 class Sys_revoke : public Sys_regs
@@ -125,6 +144,12 @@ class Sys_revoke : public Sys_regs
     public:
         ALWAYS_INLINE
         inline Crd crd() const { return Crd (ARG_2); }
+
+        ALWAYS_INLINE
+        inline bool self() const { return flags() & 0x1; }
+
+        ALWAYS_INLINE
+        inline bool batch() const { return flags() & 0x2; }
 };
 
 class Sys_lookup : public Sys_regs
@@ -139,6 +164,19 @@ class Sys_ec_ctrl : public Sys_regs
     public:
         ALWAYS_INLINE
         inline unsigned long ec() const { return ARG_1 >> 8; }
+
+        ALWAYS_INLINE
+        inline unsigned op() const { return flags() & 0x3; }
+
+        ALWAYS_INLINE
+        inline unsigned vec() const { return static_cast<unsigned>(ARG_2); }
+
+        ALWAYS_INLINE
+        inline void set_fpu (unsigned traps, unsigned loads)
+        {
+            ARG_2 = traps;
+            ARG_3 = loads;
+        }
 };
 
 class Sys_sc_ctrl : public Sys_regs
@@ -163,6 +201,12 @@ class Sys_pt_ctrl : public Sys_regs
 
         ALWAYS_INLINE
         inline mword id() const { return ARG_2; }
+
+        ALWAYS_INLINE
+        inline Crd win() const { return Crd (ARG_3); }
+
+        ALWAYS_INLINE
+        inline bool reg() const { return ARG_4 & 1; }
 };
 
 class Sys_sm_ctrl : public Sys_regs
@@ -177,8 +221,26 @@ class Sys_sm_ctrl : public Sys_regs
         ALWAYS_INLINE
         inline unsigned zc() const { return flags() & 0x2; }
 
+        ALWAYS_INLINE
+        inline unsigned bind() const { return flags() & 0x4; }
+
+        ALWAYS_INLINE
+        inline unsigned long evs() const { return ARG_2; }
+
+        ALWAYS_INLINE
+        inline unsigned evt() const { return static_cast<unsigned>(ARG_3); }
+
         ALWAYS_INLINE
         inline uint64 time() const { return static_cast<uint64>(ARG_2) << 32 | ARG_3; }
+
+        ALWAYS_INLINE
+        inline mword slack() const { return flags() & 0x8 ? ARG_4 : 0; }
+
+        ALWAYS_INLINE
+        inline void set_cnt (mword c) { ARG_2 = c; }
+
+        ALWAYS_INLINE
+        inline void set_evt (mword e) { ARG_2 = e; }
 };
 
 class Sys_assign_pci : public Sys_regs
@@ -206,6 +268,18 @@ class Sys_assign_gsi : public Sys_regs
         ALWAYS_INLINE
         inline unsigned cpu() const { return static_cast<unsigned>(ARG_3); }
 
+        ALWAYS_INLINE
+        inline bool aff() const { return flags() & 0x1; }
+
+        ALWAYS_INLINE
+        inline bool pst() const { return flags() & 0x2; }
+
+        ALWAYS_INLINE
+        inline unsigned long ec() const { return ARG_4; }
+
+        ALWAYS_INLINE
+        inline unsigned vec() const { return static_cast<unsigned>(ARG_5); }
+
         ALWAYS_INLINE
         inline void set_msi (uint64 val)
         {
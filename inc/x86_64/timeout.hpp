@@ -17,9 +17,21 @@
 
 #pragma once
 
+#include "bits.hpp"
 #include "compiler.hpp"
 #include "types.hpp"
 
+/*
+ * Timeouts are kept in a per-CPU hierarchical timing wheel. Level l has
+ * slots of 2^(tick + l * bits) cycles each. A timeout is queued on the
+ * lowest level whose higher-order bits match the current tick, so the
+ * first non-empty slot of the lowest non-empty level holds the earliest
+ * deadline. Timeouts beyond the last level go onto the far list.
+ *
+ * A timeout may expire up to slack cycles late. The deadline register is
+ * programmed with the earliest time + slack, so that all timeouts that
+ * are due by then expire with a single interrupt.
+ */
 class Timeout
 {
     protected:
@@ -28,17 +40,41 @@ class Timeout
 
         virtual void trigger() = 0;
 
-    public:
-        static Timeout *list CPULOCAL;
+    private:
+        Timeout **head;
+        uint64 slack;
+
+        static unsigned const tick   = 10;
+        static unsigned const bits   = bit_scan_reverse (8 * sizeof (mword));
+        static unsigned const slots  = 1U << bits;
+        static unsigned const levels = 5;
 
+        static Timeout **   wheel           CPULOCAL;
+        static Timeout *    far             CPULOCAL;
+        static mword        map[levels]     CPULOCAL;
+        static uint64       base            CPULOCAL;
+        static uint64       dln             CPULOCAL;
+
+        void insert (Timeout **);
+        void place();
+
+        static void collect (Timeout *&, Timeout *&);
+        static void program (uint64);
+        static uint64 expiry (Timeout *);
+        static uint64 earliest();
+        static Timeout *due (uint64);
+
+    public:
         ALWAYS_INLINE
-        inline Timeout() : prev (nullptr), next (nullptr), time (0) {}
+        inline Timeout() : prev (nullptr), next (nullptr), time (0), head (nullptr), slack (0) {}
 
         ALWAYS_INLINE
-        inline bool active() const { return prev || list == this; }
+        inline bool active() const { return head; }
 
-        void enqueue (uint64);
+        void enqueue (uint64, uint64 = 0);
         uint64 dequeue();
 
+        static void init();
         static void check();
+        static void bench();
 };
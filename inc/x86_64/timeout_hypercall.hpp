@@ -36,5 +36,5 @@ class Timeout_hypercall : public Timeout
         inline Timeout_hypercall (Ec *e) : ec (e) {}
 
         ALWAYS_INLINE
-        inline void enqueue (uint64 t, Sm *s) { sm = s; Timeout::enqueue (t); }
+        inline void enqueue (uint64 t, uint64 l, Sm *s) { sm = s; Timeout::enqueue (t, l); }
 };
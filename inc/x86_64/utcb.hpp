@@ -93,6 +93,30 @@ class Utcb : public Utcb_head, private Utcb_data
     private:
         static mword const words = (PAGE_SIZE - sizeof (Utcb_head)) / sizeof (mword);
 
+        static mword rep_min;       // Shortest message (in words) copied with string moves
+        static bool  rep_erms;      // Use REP MOVSB for string moves
+
+        // Short messages use a word loop, longer ones the string move that is fastest on this CPU
+        ALWAYS_INLINE
+        static inline void copy (mword *d, mword *s, mword n)
+        {
+            if (EXPECT_TRUE (n < rep_min))
+                for (mword i = 0; i < n; i++)
+                    d[i] = s[i];
+
+            else if (rep_erms) {
+                n *= sizeof (mword);
+                asm volatile ("rep; movsb" : "+D" (d), "+S" (s), "+c" (n) : : "memory");
+            }
+
+            else
+#ifdef __x86_64__
+                asm volatile ("rep; movsq" : "+D" (d), "+S" (s), "+c" (n) : : "memory");
+#else
+                asm volatile ("rep; movsl" : "+D" (d), "+S" (s), "+c" (n) : : "memory");
+#endif
+        }
+
     public:
         WARN_UNUSED_RESULT bool load_exc (Cpu_regs *);
         WARN_UNUSED_RESULT bool load_vmx (Cpu_regs *);
@@ -107,21 +131,22 @@ class Utcb : public Utcb_head, private Utcb_data
         inline mword ui() const { return min (words / 1, ucnt()); }
         inline mword ti() const { return min (words / 2, tcnt()); }
 
+        inline void set_ucnt (mword n) { items = n; }
+
+        inline mword *msg() { return mr; }
+
         ALWAYS_INLINE NONNULL
         inline void save (Utcb *dst)
         {
-            register mword n = ui();
-
             dst->items = items;
-#if 0
-            mword *d = dst->mr, *s = mr;
-            asm volatile ("rep; movsl" : "+D" (d), "+S" (s), "+c" (n) : : "memory");
-#else
-            for (unsigned long i = 0; i < n; i++)
-                dst->mr[i] = mr[i];
-#endif
+
+            copy (dst->mr, mr, ui());
         }
 
+        static void init();
+        static void bench();
+        static void bench_vmx();
+
         ALWAYS_INLINE
         inline Xfer *xfer() { return reinterpret_cast<Xfer *>(this) + PAGE_SIZE / sizeof (Xfer) - 1; }
 
@@ -35,3 +35,5 @@
 
 #define VEC_IPI_RRQ     (VEC_IPI + 0)
 #define VEC_IPI_RKE     (VEC_IPI + 1)
+#define VEC_IPI_PIN     (VEC_IPI + 2)
+#define VEC_IPI_PWK     (VEC_IPI + 3)
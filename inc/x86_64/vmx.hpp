@@ -91,10 +91,13 @@ class Vmcs
         static mword fix_cr4_set CPULOCAL;
         static mword fix_cr4_clr CPULOCAL;
 
+        static mword msr_bmp[2];            // Intercept all MSRs, pass through x2APIC TPR/EOI/SELF_IPI
+
         enum Encoding
         {
             // 16-Bit Control Fields
             VPID                    = 0x0000ul,
+            POSTED_INTR_NV          = 0x0002ul,
 
             // 16-Bit Guest State Fields
             GUEST_SEL_ES            = 0x0800ul,
@@ -105,6 +108,7 @@ class Vmcs
             GUEST_SEL_GS            = 0x080aul,
             GUEST_SEL_LDTR          = 0x080cul,
             GUEST_SEL_TR            = 0x080eul,
+            GUEST_INTR_STATUS       = 0x0810ul,
 
             // 16-Bit Host State Fields
             HOST_SEL_ES             = 0x0c00ul,
@@ -127,8 +131,10 @@ class Vmcs
             TSC_OFFSET_HI           = 0x2011ul,
             APIC_VIRT_ADDR          = 0x2012ul,
             APIC_ACCS_ADDR          = 0x2014ul,
+            POSTED_INTR_DESC        = 0x2016ul,
             EPTP                    = 0x201aul,
             EPTP_HI                 = 0x201bul,
+            EOI_EXIT_BITMAP         = 0x201cul,
 
             INFO_PHYS_ADDR          = 0x2400ul,
 
@@ -273,6 +279,7 @@ class Vmcs
             PIN_EXTINT              = 1ul << 0,
             PIN_NMI                 = 1ul << 3,
             PIN_VIRT_NMI            = 1ul << 5,
+            PIN_POSTED              = 1ul << 7,
         };
 
         enum Ctrl0
@@ -282,17 +289,21 @@ class Vmcs
             CPU_INVLPG              = 1ul << 9,
             CPU_CR3_LOAD            = 1ul << 15,
             CPU_CR3_STORE           = 1ul << 16,
+            CPU_TPR_SHADOW          = 1ul << 21,
             CPU_NMI_WINDOW          = 1ul << 22,
             CPU_IO                  = 1ul << 24,
             CPU_IO_BITMAP           = 1ul << 25,
+            CPU_MSR_BITMAP          = 1ul << 28,
             CPU_SECONDARY           = 1ul << 31,
         };
 
         enum Ctrl1
         {
             CPU_EPT                 = 1ul << 1,
+            CPU_VIRT_X2APIC         = 1ul << 4,
             CPU_VPID                = 1ul << 5,
             CPU_URG                 = 1ul << 7,
+            CPU_VIRT_INTR           = 1ul << 9,
         };
 
         enum Reason
@@ -356,7 +367,7 @@ class Vmcs
             return Buddy::allocator.alloc (0, Buddy::NOFILL);
         }
 
-        Vmcs (mword, mword, mword, uint64);
+        Vmcs (mword, mword, mword, uint64, mword = 0);
 
         ALWAYS_INLINE
         inline Vmcs() : rev (basic.revision)
@@ -429,6 +440,7 @@ class Vmcs
         static bool has_vpid()      { return ctrl_cpu[1].clr & CPU_VPID; }
         static bool has_urg()       { return ctrl_cpu[1].clr & CPU_URG; }
         static bool has_vnmi()      { return ctrl_pin.clr & PIN_VIRT_NMI; }
+        static bool has_pi()        { return ctrl_pin.clr & PIN_POSTED; }
 
         static void init();
 };
@@ -0,0 +1,36 @@
+/*
+ * Event Counters
+ *
+ * Copyright (C) 2019 Udo Steinberg, BedRock Systems, Inc.
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#include "counter.hpp"
+#include "stdio.hpp"
+
+unsigned Counter::tlb_local;
+unsigned Counter::tlb_remote;
+unsigned Counter::timer_saved;
+unsigned Counter::vcpu_kept;
+unsigned Counter::vcpu_load;
+
+void Counter::dump()
+{
+    trace (0, "TLBL: %16u", Counter::tlb_local);
+    trace (0, "TLBR: %16u", Counter::tlb_remote);
+    trace (0, "TSAV: %16u", Counter::timer_saved);
+    trace (0, "VKPT: %16u", Counter::vcpu_kept);
+    trace (0, "VLOD: %16u", Counter::vcpu_load);
+
+    Counter::tlb_local = Counter::tlb_remote = Counter::timer_saved = Counter::vcpu_kept = Counter::vcpu_load = 0;
+}
@@ -25,6 +25,7 @@
 #include "hazards.hpp"
 #include "smmu.hpp"
 #include "stdio.hpp"
+#include "timeout.hpp"
 #include "timer.hpp"
 #include "vmcb.hpp"
 
@@ -255,6 +256,8 @@ void Cpu::init (unsigned cpu, unsigned e)
     if (bsp)
         Smmu::init();
 
+    Timeout::init();
+
     Timer::init();
 
     Vmcb::init();
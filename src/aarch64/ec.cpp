@@ -36,7 +36,7 @@
 #include "stdio.hpp"
 
 INIT_PRIORITY (PRIO_SLAB)
-Slab_cache Ec::cache (sizeof (Ec), 32);
+Slab_cache Ec::cache ("EC", sizeof (Ec), 32);
 
 Ec *Ec::current, *Ec::fpowner;
 
@@ -98,6 +98,8 @@ void Ec::idle()
         if (EXPECT_FALSE (hzd))
             handle_hazard (hzd, idle);
 
+        Buddy::allocator.fill_zero();
+
         Cpu::halt();
     }
 }
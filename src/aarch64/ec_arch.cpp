@@ -65,6 +65,8 @@ void Ec::set_vmm_info()
     v->el2.vmpidr = Cpu::mpidr;
     v->el2.vpidr  = Cpu::midr;
 
+    v->dirty = true;
+
     send_msg<ret_user_vmexit>();
 }
 
@@ -117,7 +119,7 @@ void Ec::ret_user_hypercall()
     if (EXPECT_FALSE (hzd))
         handle_hazard (hzd, ret_user_hypercall);
 
-    if (Vmcb::current)
+    if (Vmcb::active)
         Vmcb::load_hst();
 
     current->pd->Space_mem::make_current_hst();
@@ -135,7 +137,7 @@ void Ec::ret_user_exception()
     if (EXPECT_FALSE (hzd))
         handle_hazard (hzd, ret_user_exception);
 
-    if (Vmcb::current)
+    if (Vmcb::active)
         Vmcb::load_hst();
 
     current->pd->Space_mem::make_current_hst();
@@ -153,7 +155,7 @@ void Ec::ret_user_vmexit()
 
     trace (TRACE_CONT, "EC:%p %s to M:%#x IP:%#lx", static_cast<void *>(current), __func__, current->regs.emode(), current->regs.el2_elr);
 
-    if (Vmcb::current != current->vmcb)
+    if (EXPECT_FALSE (!Vmcb::active || Vmcb::current != current->vmcb))
         current->vmcb->load_gst();
 
     current->pd->Space_mem::make_current_gst();
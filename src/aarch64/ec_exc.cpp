@@ -42,14 +42,8 @@ void (*const syscall[16])() =
     &Ec::sys_finish<Sys_regs::BAD_HYP>,
 };
 
-void Ec::switch_fpu()
+void Ec::claim_fpu()
 {
-    assert (!(Cpu::hazard & HZD_FPU));
-    assert (fpowner != this);
-
-    if (EXPECT_FALSE (!fpu))
-        return;
-
     Fpu::enable();
 
     if (EXPECT_TRUE (fpowner)) {
@@ -63,6 +57,30 @@ void Ec::switch_fpu()
     trace (TRACE_FPU, "Switching FPU %p -> %p", static_cast<void *>(fpowner), static_cast<void *>(this));
 
     fpowner = this;
+}
+
+void Ec::adapt_fpu()
+{
+    if (--fpu_score < fpu_eager)
+        return;
+
+    fpu_loads++;
+
+    claim_fpu();
+}
+
+void Ec::switch_fpu()
+{
+    assert (!(Cpu::hazard & HZD_FPU));
+    assert (fpowner != this);
+
+    if (EXPECT_FALSE (!fpu))
+        return;
+
+    fpu_traps++;
+    fpu_score = min (fpu_score + fpu_boost, fpu_limit);
+
+    claim_fpu();
 
     subtype == Kobject::Subtype::EC_VCPU ? ret_user_vmexit() : ret_user_exception();
 }
@@ -133,6 +151,10 @@ void Ec::handle_irq_user()
 
     current->vmcb->save_gst();
 
+    // The virtual timer goes straight into a list register, unless the VMM handles it
+    if (evt == Event::Selector::VTIMER && Interrupt::inject_vtimer (current->vmcb))
+        evt = Event::Selector::NONE;
+
     if (evt == Event::Selector::NONE)
         ret_user_vmexit();
 
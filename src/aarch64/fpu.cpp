@@ -18,4 +18,4 @@
 #include "fpu.hpp"
 
 INIT_PRIORITY (PRIO_SLAB)
-Slab_cache Fpu::cache (sizeof (Fpu), 16);
+Slab_cache Fpu::cache ("FPU", sizeof (Fpu), 16);
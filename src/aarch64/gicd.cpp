@@ -116,18 +116,29 @@ void Gicd::conf (unsigned i, bool edge, unsigned cpu)
     if (i >= ints)
         return;
 
-    Lock_guard <Spinlock> guard (lock);
+    {   Lock_guard <Spinlock> guard (lock);
 
-    // Configure trigger mode
-    auto v = read (Array32::ICFGR, i / 16);
-    v &= ~(0x3U << 2 * (i % 16));
-    v |= (static_cast<uint32>(edge) << 1) << 2 * (i % 16);
-    write (Array32::ICFGR, i / 16, v);
+        // Configure trigger mode
+        auto v = read (Array32::ICFGR, i / 16);
+        v &= ~(0x3U << 2 * (i % 16));
+        v |= (static_cast<uint32>(edge) << 1) << 2 * (i % 16);
+        write (Array32::ICFGR, i / 16, v);
+    }
 
     // SGI/PPI CPU targets are read-only
-    if (i < SPI_BASE)
+    if (i >= SPI_BASE)
+        route (i, cpu);
+}
+
+void Gicd::route (unsigned i, unsigned cpu)
+{
+    assert (i >= SPI_BASE);
+
+    if (i >= ints)
         return;
 
+    Lock_guard <Spinlock> guard (lock);
+
     // Configure SPI CPU target
     if (arch < 3) {
         auto t = read (Array32::ITARGETSR, i / 4);
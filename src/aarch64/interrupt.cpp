@@ -25,6 +25,7 @@
 #include "smmu.hpp"
 #include "stdio.hpp"
 #include "timer.hpp"
+#include "vmcb.hpp"
 
 Interrupt Interrupt::int_table[SPI_NUM];
 
@@ -79,7 +80,7 @@ Event::Selector Interrupt::handle_ppi (uint32 val, bool vcpu)
     return evt;
 }
 
-Event::Selector Interrupt::handle_spi (uint32 val, bool)
+Event::Selector Interrupt::handle_spi (uint32 val, bool vcpu)
 {
     unsigned spi = (val & 0x3ff) - SPI_BASE;
 
@@ -96,7 +97,15 @@ Event::Selector Interrupt::handle_spi (uint32 val, bool)
         default:
             Gicc::eoi (val);
 
-            if (!int_table[spi].gst)
+            // Inject only into the interrupted guest, a stopped vCPU may get its LRs replaced by the VMM
+            if (vcpu && int_table[spi].vmb && Vmcb::current == int_table[spi].vmb && int_table[spi].vmb->inject (int_table[spi].tpl, spi + SPI_BASE))
+                break;
+
+            // Steered SPIs stay masked instead of active, so any CPU can acknowledge them
+            if (int_table[spi].aff) {
+                Gicd::mask (spi + SPI_BASE, true);
+                Gicc::dir (val);
+            } else if (!int_table[spi].gst)
                 int_table[spi].dir = true;
 
             int_table[spi].sm->up();
@@ -146,17 +155,25 @@ void Interrupt::conf_ppi (unsigned ppi, bool msk, bool trg)
     (Gicd::arch < 3 ? Gicd::mask : Gicr::mask) (ppi + PPI_BASE, msk);
 }
 
-void Interrupt::conf_spi (unsigned spi, unsigned cpu, bool msk, bool trg, bool gst)
+void Interrupt::conf_spi (unsigned spi, unsigned cpu, bool msk, bool trg, bool gst, bool aff, Vmcb *vmb, uint64 tpl)
 {
-    trace (TRACE_INTR, "INTR: %s: %u cpu=%u %c%c%c", __func__, spi, cpu, msk ? 'M' : 'U', trg ? 'E' : 'L', gst ? 'G' : 'H');
+    trace (TRACE_INTR, "INTR: %s: %u cpu=%u %c%c%c%s%s", __func__, spi, cpu, msk ? 'M' : 'U', trg ? 'E' : 'L', gst ? 'G' : 'H', aff ? "A" : "", vmb ? "V" : "");
 
     int_table[spi].cpu  = static_cast<uint16>(cpu);
     int_table[spi].gst  = gst;
+    int_table[spi].aff  = aff && !gst;
+    int_table[spi].vmb  = gst ? vmb : nullptr;
+    int_table[spi].tpl  = tpl;
 
     Gicd::conf (spi + SPI_BASE, trg, cpu);
     Gicd::mask (spi + SPI_BASE, msk);
 }
 
+bool Interrupt::inject_vtimer (Vmcb *v)
+{
+    return v->vtm && v->inject (v->vtm, VTIMER_PPI + PPI_BASE);
+}
+
 void Interrupt::send_sgi (Sgi sgi, unsigned cpu)
 {
     (Gicd::arch < 3 ? Gicd::send_sgi : Gicc::send_sgi) (sgi, cpu);
@@ -164,6 +181,17 @@ void Interrupt::send_sgi (Sgi sgi, unsigned cpu)
 
 void Interrupt::deactivate_spi (unsigned spi)
 {
+    if (int_table[spi].aff) {
+
+        if (int_table[spi].cpu != Cpu::id) {
+            int_table[spi].cpu = static_cast<uint16>(Cpu::id);
+            Gicd::route (spi + SPI_BASE, Cpu::id);
+        }
+
+        Gicd::mask (spi + SPI_BASE, false);
+        return;
+    }
+
     if (int_table[spi].dir) {
         int_table[spi].dir = false;
         Gicc::dir (spi + SPI_BASE);
@@ -23,7 +23,7 @@
 #include "stdio.hpp"
 
 INIT_PRIORITY (PRIO_SLAB)
-Slab_cache Pd::cache (sizeof (Pd), 32);
+Slab_cache Pd::cache ("PD", sizeof (Pd), 32);
 
 ALIGNED(32) Pd Pd::kern (USER_ADDR);
 ALIGNED(32) Pd Pd::root;
@@ -91,5 +91,8 @@ void Pd::update_mem_space (Pd *pd, mword src, mword dst, unsigned ord, unsigned
         Space_mem::update (d, p, o, pm, mt, sh, si);
     }
 
-    Space_mem::flush (si);
+    if (1UL << ord <= tlb_max)
+        Space_mem::flush (si, dst << PAGE_BITS, ord);
+    else
+        Space_mem::flush (si);
 }
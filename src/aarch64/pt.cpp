@@ -24,7 +24,7 @@
 #include "stdio.hpp"
 
 INIT_PRIORITY (PRIO_SLAB)
-Slab_cache Pt::cache (sizeof (Pt), 32);
+Slab_cache Pt::cache ("PT", sizeof (Pt), 32);
 
 Pt::Pt (Ec *e, mword i) : Kobject (Kobject::Type::PT), ec (e), ip (i)
 {
@@ -31,15 +31,16 @@
 #include "timer.hpp"
 
 INIT_PRIORITY (PRIO_SLAB)
-Slab_cache Sc::cache (sizeof (Sc), 32);
+Slab_cache Sc::cache ("SC", sizeof (Sc), 32);
 
 INIT_PRIORITY (PRIO_LOCAL)
 Sc::Rq Sc::rq;
 
 unsigned    Sc::ctr_link;
 unsigned    Sc::ctr_loop;
-unsigned    Sc::prio_top;
 Sc *        Sc::list[priorities];
+mword       Sc::prio_map[priorities / prio_bits];
+mword       Sc::prio_sum;
 Sc *        Sc::current;
 
 Sc::Sc (unsigned c, Ec *e, unsigned p, unsigned b) : Kobject (Kobject::Type::SC), cpu (c), ec (e), prio (p), budget (Timer::ms_to_ticks (b))
@@ -52,12 +53,11 @@ void Sc::ready_enqueue (uint64 t)
     assert (cpu == Cpu::id);
     assert (prio < priorities);
 
-    if (prio > prio_top)
-        prio_top = prio;
-
-    if (!list[prio])
+    if (!list[prio]) {
         list[prio] = prev = next = this;
-    else {
+        prio_map[prio / prio_bits] |= 1UL << prio % prio_bits;
+        prio_sum |= 1UL << prio / prio_bits;
+    } else {
         next = list[prio];
         prev = list[prio]->prev;
         next->prev = prev->next = this;
@@ -83,13 +83,13 @@ void Sc::ready_dequeue (uint64 t)
     if (list[prio] == this)
         list[prio] = next == this ? nullptr : next;
 
+    if (!list[prio] && !(prio_map[prio / prio_bits] &= ~(1UL << prio % prio_bits)))
+        prio_sum &= ~(1UL << prio / prio_bits);
+
     next->prev = prev;
     prev->next = next;
     prev = next = nullptr;
 
-    while (!list[prio_top] && prio_top)
-        prio_top--;
-
 #if 0
     ec->add_offset_ticks (t - last);
 #endif
@@ -113,7 +113,7 @@ void Sc::schedule (bool suspend)
     if (EXPECT_TRUE (!suspend))
         current->ready_enqueue (t);
 
-    for (Sc *sc; (current = sc = list[prio_top]); ) {
+    for (Sc *sc; (current = sc = list[prio_top()]); ) {
 
         ctr_loop = 0;
 
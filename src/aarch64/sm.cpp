@@ -23,9 +23,37 @@
 #include "stdio.hpp"
 
 INIT_PRIORITY (PRIO_SLAB)
-Slab_cache Sm::cache (sizeof (Sm), 32);
+Slab_cache Sm::cache ("SM", sizeof (Sm), 32);
 
-Sm::Sm (mword c, unsigned i) : Kobject (Kobject::Type::SM), counter (c), spi (i)
+Sm::Sm (mword c, unsigned i, bool s) : Kobject (Kobject::Type::SM), counter (s ? 0 : c), spi (i), set (s)
 {
-    trace (TRACE_CREATE, "SM:%p created (CNT:%lu SPI:%u)", static_cast<void *>(this), c, i);
+    trace (TRACE_CREATE, "SM:%p created (CNT:%lu SPI:%u SET:%u)", static_cast<void *>(this), c, i, s);
+}
+
+bool Sm::bind (Sm *s, unsigned bit)
+{
+    mword c;
+
+    {   Lock_guard <Spinlock> guard (lock);
+
+        if (EXPECT_FALSE (set || head()))
+            return false;
+
+        if (!s) {
+            evs = nullptr;
+            return true;
+        }
+
+        // Signals that arrived before the binding are passed on
+        c = counter;
+        counter = 0;
+
+        evt = BIT64 (bit);
+        evs = s;
+    }
+
+    if (c)
+        s->signal (evt);
+
+    return true;
 }
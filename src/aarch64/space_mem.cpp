@@ -19,6 +19,7 @@
  * GNU General Public License version 2 for more details.
  */
 
+#include "counter.hpp"
 #include "space_mem.hpp"
 
 void Space_mem::update (uint64 v, uint64 p, unsigned o, Paging::Permissions pm, Memtype::Index mt, Memtype::Shareability sh, Space::Index si)
@@ -31,12 +32,38 @@ void Space_mem::update (uint64 v, uint64 p, unsigned o, Paging::Permissions pm,
     }
 }
 
+/*
+ * TLB entries of a space can only exist on CPUs that have used it. If that
+ * is at most this CPU, a local invalidation suffices. Otherwise broadcast
+ * to the inner-shareable domain, which contains all CPUs.
+ */
+bool Space_mem::bcast (Space::Index si)
+{
+    asm volatile ("dsb ish" : : : "memory");    // Order PTE writes before reading the CPU set
+
+    bool b = !(si == Space::Index::MEM_GST ? cpus_gst : cpus_hst).only (Cpu::id);
+
+    (b ? Counter::tlb_remote : Counter::tlb_local)++;
+
+    return b;
+}
+
 void Space_mem::flush (Space::Index si)
 {
     switch (si) {
-        case Space::Index::MEM_HST: mem_hst.flush (id_hst); break;
-        case Space::Index::MEM_GST: mem_gst.flush (id_gst); break;
-        case Space::Index::DMA_HST: dma_hst.flush (id_hst); break;
-        case Space::Index::DMA_GST: dma_gst.flush (id_gst); break;
+        case Space::Index::MEM_HST: mem_hst.flush (id_hst, bcast (si)); break;
+        case Space::Index::MEM_GST: mem_gst.flush (id_gst, bcast (si)); break;
+        case Space::Index::DMA_HST: dma_hst.flush (id_hst, false); break;
+        case Space::Index::DMA_GST: dma_gst.flush (id_gst, false); break;
+    }
+}
+
+void Space_mem::flush (Space::Index si, uint64 v, unsigned o)
+{
+    switch (si) {
+        case Space::Index::MEM_HST: mem_hst.flush (id_hst, bcast (si), v, o); break;
+        case Space::Index::MEM_GST: mem_gst.flush (id_gst, bcast (si), v, o); break;
+        case Space::Index::DMA_HST: dma_hst.flush (id_hst, false, v, o); break;
+        case Space::Index::DMA_GST: dma_gst.flush (id_gst, false, v, o); break;
     }
 }
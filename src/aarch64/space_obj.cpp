@@ -24,28 +24,32 @@
 #include "space_obj.hpp"
 #include "stdio.hpp"
 
-Capability *Space_obj::walk (unsigned long sel)
+Capability *Space_obj::walk (unsigned long sel, bool a)
 {
-    unsigned l = lev;
+    Capability **e = &root;
 
-    for (Capability **e = &root;; e = reinterpret_cast<Capability **>(*e) + (sel >> (--l * bpl) & ((1UL << bpl) - 1))) {
+    for (unsigned l = lev; l--; e = reinterpret_cast<Capability **>(*e) + (sel >> (l * bpl) & ((1UL << bpl) - 1))) {
 
-//        trace (0, "  %s: l=%u e=%p", __func__, l, e);
+        if (EXPECT_TRUE (Atomic::load (*e)))
+            continue;
 
-        if (!l)
-            return reinterpret_cast<Capability *>(e);
+        // Lookups must not grow the table
+        if (!a)
+            return nullptr;
 
-        // No cap table yet, allocate one
-        if (!*e) {
-            *e = static_cast<Capability *>(Buddy::allocator.alloc (0, Buddy::FILL_0));
-//            trace (0, "    ==> l=%u e=%p => %p allocated", l - 1, e, *e);
-        }
+        // No cap table yet, allocate one and race concurrent inserts for the slot
+        Capability *o = nullptr, *t = static_cast<Capability *>(Buddy::allocator.alloc (0, Buddy::FILL_0));
+
+        if (!Atomic::cmp_swap (*e, o, t))
+            Buddy::allocator.free (reinterpret_cast<mword>(t));
     }
+
+    return reinterpret_cast<Capability *>(e);
 }
 
 Capability Space_obj::lookup (unsigned long sel)
 {
-    Capability *ptr = walk (sel);
+    Capability *ptr = walk (sel, false);
 
     return ptr ? *ptr : Capability (0);
 }
@@ -54,23 +58,32 @@ void Space_obj::update (unsigned long sel, Capability cap)
 {
 //    trace (0, "%s: sel=%lu", __func__, sel);
 
-    Capability *ptr = walk (sel);
+    Capability *ptr = walk (sel, true);
     assert (ptr);
 
 //    trace (0, "%s: got ptr=%p", __func__, ptr);
 
     // XXX: Handle the old capability
     Capability::exchange (ptr, cap);
+
+    // Invalidate capabilities cached by lookups
+    Atomic::add (gen, 1UL);
 }
 
 bool Space_obj::insert (unsigned long sel, Capability cap)
 {
 //    trace (0, "%s: sel=%lu", __func__, sel);
 
-    Capability *ptr = walk (sel);
+    Capability *ptr = walk (sel, true);
     assert (ptr);
 
 //    trace (0, "%s: got ptr=%p", __func__, ptr);
 
-    return Capability::compare_exchange (ptr, Capability (0), cap);
+    if (!Capability::compare_exchange (ptr, Capability (0), cap))
+        return false;
+
+    // Invalidate failed lookups cached for this selector
+    Atomic::add (gen, 1UL);
+
+    return true;
 }
@@ -21,6 +21,7 @@
  */
 
 #include "assert.hpp"
+#include "counter.hpp"
 #include "ec.hpp"
 #include "hazards.hpp"
 #include "interrupt.hpp"
@@ -124,7 +125,7 @@ void Ec::sys_ipc_call()
 {
     auto r = static_cast<Sys_ipc_call *>(current->sys_regs());
 
-    auto cap = current->pd->Space_obj::lookup (r->pt());
+    auto cap = current->lookup_pt (r->pt());
     if (EXPECT_FALSE (!cap.validate (Kobject::Type::PT, 1)))
         sys_finish<Sys_regs::BAD_CAP>();
 
@@ -322,7 +323,7 @@ void Ec::sys_create_sm()
         sys_finish<Sys_regs::BAD_CAP>();
     }
 
-    auto sm = Sm::create (r->cnt());
+    auto sm = Sm::create (r->cnt(), ~0U, r->set());
 
     if (!current->pd->Space_obj::insert (r->sel(), Capability (sm, 0x1f))) {
         trace (TRACE_ERROR, "%s: Non-NULL CAP (%#lx)", __func__, r->sel());
@@ -396,6 +397,23 @@ void Ec::sys_ctrl_ec()
 
     auto ec = static_cast<Ec *>(cap.obj());
 
+    if (r->fpu()) {
+        r->set_fpu (ec->fpu_traps, ec->fpu_loads);
+        sys_finish<Sys_regs::SUCCESS>();
+    }
+
+    if (r->vtm()) {
+
+        if (EXPECT_FALSE (ec->subtype != Kobject::Subtype::EC_VCPU)) {
+            trace (TRACE_ERROR, "%s: Non-VCPU EC CAP (%#lx)", __func__, r->ec());
+            sys_finish<Sys_regs::BAD_CAP>();
+        }
+
+        ec->vmcb->vtm = r->tpl();
+
+        sys_finish<Sys_regs::SUCCESS>();
+    }
+
     if (!(ec->hazard & HZD_RECALL)) {
 
         ec->set_hazard (HZD_RECALL);
@@ -458,9 +476,30 @@ void Ec::sys_ctrl_sm()
 
     auto sm = static_cast<Sm *>(cap.obj());
 
+    if (r->bind()) {
+
+        auto set = current->pd->Space_obj::lookup (r->evs());
+        if (EXPECT_FALSE (set.obj() && (!set.validate (Kobject::Type::SM, 1) || !static_cast<Sm *>(set.obj())->set))) {
+            trace (TRACE_ERROR, "%s: Bad SET CAP (%#lx)", __func__, r->evs());
+            sys_finish<Sys_regs::BAD_CAP>();
+        }
+
+        if (EXPECT_FALSE (r->evt() >= sizeof (mword) * 8 || !sm->bind (static_cast<Sm *>(set.obj()), r->evt()))) {
+            trace (TRACE_ERROR, "%s: Bad SET member (%u)", __func__, r->evt());
+            sys_finish<Sys_regs::BAD_PAR>();
+        }
+
+        sys_finish<Sys_regs::SUCCESS>();
+    }
+
     switch (r->op()) {
 
         case 0:
+            // An event set is only signalled through its members
+            if (EXPECT_FALSE (sm->set)) {
+                trace (TRACE_ERROR, "%s: Up on SET (%#lx)", __func__, r->sm());
+                sys_finish<Sys_regs::BAD_PAR>();
+            }
             if (!sm->up())
                 sys_finish<Sys_regs::OVRFLOW>();
             break;
@@ -470,7 +509,7 @@ void Ec::sys_ctrl_sm()
 
             if (spi != ~0U) {
 
-                if (Interrupt::int_table[spi].cpu != Cpu::id) {
+                if (Interrupt::int_table[spi].cpu != Cpu::id && !Interrupt::int_table[spi].aff) {
                     trace (TRACE_ERROR, "%s: Invalid CPU (%u)", __func__, Cpu::id);
                     sys_finish<Sys_regs::BAD_CPU>();
                 }
@@ -478,7 +517,7 @@ void Ec::sys_ctrl_sm()
                 Interrupt::deactivate_spi (spi);
             }
 
-            sm->dn (r->zc(), r->time_ticks());
+            sm->dn (r->zc(), r->time_ticks(), r->slack_ticks());
             break;
     }
 
@@ -496,6 +535,12 @@ void Ec::sys_ctrl_hw()
         sys_finish<Sys_regs::BAD_HYP>();
     }
 
+    // Dump the event counters of this CPU
+    if (r->op() == 0) {
+        Counter::dump();
+        sys_finish<Sys_regs::SUCCESS>();
+    }
+
     if (EXPECT_FALSE (r->op() != 0xf)) {
         trace (TRACE_ERROR, "%s: Bad OP (%#x)", __func__, r->op());
         sys_finish<Sys_regs::BAD_PAR>();
@@ -546,7 +591,28 @@ void Ec::sys_assign_int()
         sys_finish<Sys_regs::BAD_CAP>();
     }
 
-    Interrupt::conf_spi (spi, r->cpu(), r->msk(), r->trg(), r->gst());
+    Vmcb *vmb = nullptr;
+
+    if (r->inj()) {
+
+        auto obj = current->pd->Space_obj::lookup (r->ec());
+        if (EXPECT_FALSE (!obj.validate (Kobject::Type::EC, 0) || static_cast<Ec *>(obj.obj())->subtype != Kobject::Subtype::EC_VCPU)) {
+            trace (TRACE_ERROR, "%s: Bad VCPU CAP (%#lx)", __func__, r->ec());
+            sys_finish<Sys_regs::BAD_CAP>();
+        }
+
+        auto ec = static_cast<Ec *>(obj.obj());
+
+        // Injection needs the interrupt on the CPU of the vCPU and deactivated by the guest
+        if (EXPECT_FALSE (ec->cpu != r->cpu() || !r->gst() || r->aff())) {
+            trace (TRACE_ERROR, "%s: Cannot inject SPI %u", __func__, spi);
+            sys_finish<Sys_regs::BAD_PAR>();
+        }
+
+        vmb = ec->vmcb;
+    }
+
+    Interrupt::conf_spi (spi, r->cpu(), r->msk(), r->trg(), r->gst(), r->aff(), vmb, r->tpl());
 
     sys_finish<Sys_regs::SUCCESS>();
 }
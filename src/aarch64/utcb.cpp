@@ -177,6 +177,13 @@ bool Utcb::save (Mtd_arch mtd, Exc_regs *r, Vmcb *v) const
     if (!v)
         return !r->emode();
 
+    // Reload the state that stays live across host ECs on the next entry
+    if (m & (Mtd_arch::Item::A32_SPSR  | Mtd_arch::Item::A32_DACR_IFSR |
+             Mtd_arch::Item::EL1_SP    | Mtd_arch::Item::EL1_IDR       | Mtd_arch::Item::EL1_ELR_SPSR | Mtd_arch::Item::EL1_ESR_FAR |
+             Mtd_arch::Item::EL1_AFSR  | Mtd_arch::Item::EL1_TTBR      | Mtd_arch::Item::EL1_TCR      | Mtd_arch::Item::EL1_MAIR    |
+             Mtd_arch::Item::EL1_VBAR  | Mtd_arch::Item::EL2_IDR       | Mtd_arch::Item::EL2_HCR      | Mtd_arch::Item::GIC))
+        v->dirty = true;
+
     // EL2_HPFAR state is read-only
 
     if (m & Mtd_arch::Item::A32_SPSR) {
@@ -251,17 +258,8 @@ bool Utcb::save (Mtd_arch mtd, Exc_regs *r, Vmcb *v) const
 
     if (m & Mtd_arch::Item::GIC) {
 
-        if (Gicc::mode == Gicc::Mode::REGS)                                     // UTCBv3 => GICv3
-            for (unsigned i = 0; i < Gich::num_lr; i++)
-                v->gic.lr[i] = arch.gic.lr[i];
-
-        else                                                                    // UTCBv3 => GICv2
-            for (unsigned i = 0; i < Gich::num_lr; i++)
-                v->gic.lr[i] = (arch.gic.lr[i] & 0xc000000000000000) >> 34 |    // State (2 bits)
-                               (arch.gic.lr[i] & 0x3000000000000000) >> 30 |    // HW + Grp (2 bits)
-                               (arch.gic.lr[i] & 0x00f8000000000000) >> 28 |    // Priority (5 bits)
-                               (arch.gic.lr[i] & 0x000003ff00000000) >> 22 |    // pINTID (10 bits)
-                               (arch.gic.lr[i] & 0x00000000000003ff);           // vINTID (10 bits)
+        for (unsigned i = 0; i < Gich::num_lr; i++)                             // UTCBv3 => GICv3/GICv2
+            v->gic.lr[i] = Gich::lr_gic (arch.gic.lr[i]);
 
         // GIC ELRSR and VMCR are read-only
     }
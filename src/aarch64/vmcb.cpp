@@ -15,12 +15,14 @@
  * GNU General Public License version 2 for more details.
  */
 
+#include "counter.hpp"
 #include "cpu.hpp"
 #include "fpu.hpp"
 #include "gich.hpp"
 #include "vmcb.hpp"
 
 Vmcb const *Vmcb::current;
+bool        Vmcb::active;
 
 void Vmcb::init()
 {
@@ -28,67 +30,132 @@ void Vmcb::init()
 
     Fpu::disable();
 
+    current = nullptr;
+
     load_hst();
 }
 
+/*
+ * Host ECs run at EL0 with HCR_EL2.TGE set and never touch most of the EL1
+ * and vGIC state. Only the registers that affect EL0 are switched, the rest
+ * of the guest state stays live for the next entry of the same vCPU.
+ *
+ * The guest state was saved on the VM exit that preceded this switch, so it
+ * tells which registers already hold the host value and can be left alone.
+ */
 void Vmcb::load_hst()
 {
-    current = nullptr;
+    uint64 const cpacr   = BIT64_RANGE (21, 20);
+    uint64 const sctlr   = SCTLR_A64_UCI | SCTLR_A64_UCT | SCTLR_A64_DZE | SCTLR_ALL_I | SCTLR_A64_SA0 | SCTLR_A64_SA | SCTLR_ALL_C | SCTLR_ALL_A | SCTLR_ALL_M;
+    uint64 const cntkctl = BIT64 (1);
+
+    auto const v = active ? current : nullptr;
+
+    active = false;
+
+    if (!v || v->el1.cpacr != cpacr)
+        asm volatile ("msr cpacr_el1,       %0" : : "r" (cpacr));
+    if (!v || v->el1.sctlr != sctlr)
+        asm volatile ("msr sctlr_el1,       %0" : : "r" (sctlr));
 
-    asm volatile ("msr cpacr_el1,       %0" : : "r" (BIT64_RANGE (21, 20)));
-    asm volatile ("msr sctlr_el1,       %0" : : "r" (SCTLR_A64_UCI | SCTLR_A64_UCT | SCTLR_A64_DZE | SCTLR_ALL_I | SCTLR_A64_SA0 | SCTLR_A64_SA | SCTLR_ALL_C | SCTLR_ALL_A | SCTLR_ALL_M));
     asm volatile ("msr hcr_el2,         %0" : : "r" (HCR_RW | HCR_TGE | HCR_DC | HCR_VM));  // TGE entails AMO, IMO, FMO
 
     asm volatile ("msr cntvoff_el2,     %0" : : "r" (0ULL));
-    asm volatile ("msr cntkctl_el1,     %0" : : "r" (BIT64 (1)));
-    asm volatile ("msr cntv_ctl_el0,    %0" : : "r" (0ULL));
+
+    if (!v || v->tmr.cntkctl != cntkctl)
+        asm volatile ("msr cntkctl_el1,     %0" : : "r" (cntkctl));
+    if (!v || v->tmr.cntv_ctl & BIT64 (0))
+        asm volatile ("msr cntv_ctl_el0,    %0" : : "r" (0ULL));
 
     Gich::disable();
 }
 
-void Vmcb::load_gst() const
+void Vmcb::load_gst()
 {
-    current = this;
+    if (EXPECT_FALSE (current != this || dirty)) {
+
+        Counter::vcpu_load++;
+
+        asm volatile ("msr afsr0_el1,       %0" : : "r" (el1.afsr0));
+        asm volatile ("msr afsr1_el1,       %0" : : "r" (el1.afsr1));
+        asm volatile ("msr amair_el1,       %0" : : "r" (el1.amair));
+        asm volatile ("msr contextidr_el1,  %0" : : "r" (el1.contextidr));
+        asm volatile ("msr elr_el1,         %0" : : "r" (el1.elr));
+        asm volatile ("msr esr_el1,         %0" : : "r" (el1.esr));
+        asm volatile ("msr far_el1,         %0" : : "r" (el1.far));
+        asm volatile ("msr mair_el1,        %0" : : "r" (el1.mair));
+        asm volatile ("msr par_el1,         %0" : : "r" (el1.par));
+        asm volatile ("msr sp_el1,          %0" : : "r" (el1.sp));
+        asm volatile ("msr spsr_el1,        %0" : : "r" (el1.spsr));
+        asm volatile ("msr tcr_el1,         %0" : : "r" (el1.tcr));
+        asm volatile ("msr tpidr_el1,       %0" : : "r" (el1.tpidr));
+        asm volatile ("msr ttbr0_el1,       %0" : : "r" (el1.ttbr0));
+        asm volatile ("msr ttbr1_el1,       %0" : : "r" (el1.ttbr1));
+        asm volatile ("msr vbar_el1,        %0" : : "r" (el1.vbar));
+
+//      asm volatile ("msr vdisr_el2,       %0" : : "r" (el2.vdisr));   // RAS
+        asm volatile ("msr vmpidr_el2,      %0" : : "r" (el2.vmpidr));
+        asm volatile ("msr vpidr_el2,       %0" : : "r" (el2.vpidr));
+
+        if (EXPECT_FALSE (!(el2.hcr & HCR_RW))) {
+            asm volatile ("msr dacr32_el2,  %0" : : "r" (a32.dacr));
+            asm volatile ("msr ifsr32_el2,  %0" : : "r" (a32.ifsr));
+            asm volatile ("msr spsr_abt,    %0" : : "r" (a32.spsr_abt));
+            asm volatile ("msr spsr_fiq,    %0" : : "r" (a32.spsr_fiq));
+            asm volatile ("msr spsr_irq,    %0" : : "r" (a32.spsr_irq));
+            asm volatile ("msr spsr_und,    %0" : : "r" (a32.spsr_und));
+        }
+
+        Gich::load (gic.lr, gic.ap0r, gic.ap1r, gic.hcr, gic.vmcr);
+
+        current = this;
+        dirty   = false;
+
+    } else {
+
+        Gich::enable (gic.hcr);
+
+        Counter::vcpu_kept++;
+    }
+
+    active = true;
 
-    asm volatile ("msr afsr0_el1,       %0" : : "r" (el1.afsr0));
-    asm volatile ("msr afsr1_el1,       %0" : : "r" (el1.afsr1));
-    asm volatile ("msr amair_el1,       %0" : : "r" (el1.amair));
-    asm volatile ("msr contextidr_el1,  %0" : : "r" (el1.contextidr));
     asm volatile ("msr cpacr_el1,       %0" : : "r" (el1.cpacr));
-    asm volatile ("msr elr_el1,         %0" : : "r" (el1.elr));
-    asm volatile ("msr esr_el1,         %0" : : "r" (el1.esr));
-    asm volatile ("msr far_el1,         %0" : : "r" (el1.far));
-    asm volatile ("msr mair_el1,        %0" : : "r" (el1.mair));
-    asm volatile ("msr par_el1,         %0" : : "r" (el1.par));
     asm volatile ("msr sctlr_el1,       %0" : : "r" (el1.sctlr));
-    asm volatile ("msr sp_el1,          %0" : : "r" (el1.sp));
-    asm volatile ("msr spsr_el1,        %0" : : "r" (el1.spsr));
-    asm volatile ("msr tcr_el1,         %0" : : "r" (el1.tcr));
-    asm volatile ("msr tpidr_el1,       %0" : : "r" (el1.tpidr));
-    asm volatile ("msr ttbr0_el1,       %0" : : "r" (el1.ttbr0));
-    asm volatile ("msr ttbr1_el1,       %0" : : "r" (el1.ttbr1));
-    asm volatile ("msr vbar_el1,        %0" : : "r" (el1.vbar));
 
     asm volatile ("msr hcr_el2,         %0" : : "r" (el2.hcr));
-//  asm volatile ("msr vdisr_el2,       %0" : : "r" (el2.vdisr));   // RAS
-    asm volatile ("msr vmpidr_el2,      %0" : : "r" (el2.vmpidr));
-    asm volatile ("msr vpidr_el2,       %0" : : "r" (el2.vpidr));
-
-    if (EXPECT_FALSE (!(el2.hcr & HCR_RW))) {
-        asm volatile ("msr dacr32_el2,  %0" : : "r" (a32.dacr));
-        asm volatile ("msr ifsr32_el2,  %0" : : "r" (a32.ifsr));
-        asm volatile ("msr spsr_abt,    %0" : : "r" (a32.spsr_abt));
-        asm volatile ("msr spsr_fiq,    %0" : : "r" (a32.spsr_fiq));
-        asm volatile ("msr spsr_irq,    %0" : : "r" (a32.spsr_irq));
-        asm volatile ("msr spsr_und,    %0" : : "r" (a32.spsr_und));
-    }
 
     asm volatile ("msr cntvoff_el2,     %0" : : "r" (tmr.cntvoff));
     asm volatile ("msr cntkctl_el1,     %0" : : "r" (tmr.cntkctl));
     asm volatile ("msr cntv_cval_el0,   %0" : : "r" (tmr.cntv_cval));
     asm volatile ("msr cntv_ctl_el0,    %0" : : "r" (tmr.cntv_ctl));
+}
+
+/*
+ * Place an interrupt into a free list register. The entry is linked to the
+ * physical interrupt, which stays active until the guest deactivates it, so
+ * the same source cannot be pending twice. The template from the VMM
+ * provides the virtual INTID, priority and group.
+ */
+bool Vmcb::inject (uint64 tpl, unsigned intid)
+{
+    uint64 const lr = Gich::lr_gic ((tpl & (BIT64 (60) | BIT64_RANGE (55, 48) | BIT64_RANGE (31, 0))) | BIT64 (62) | BIT64 (61) | uint64 (intid) << 32);
+
+    for (unsigned i = 0; i < Gich::num_lr; i++) {
+
+        if (!Gich::lr_free (gic.lr[i]))
+            continue;
+
+        gic.lr[i] = lr;
+
+        // The list registers still hold our state, unless the VMM replaced it
+        if (current == this && !dirty)
+            Gich::set_lr (i, lr);
+
+        return true;
+    }
 
-    Gich::load (gic.lr, gic.ap0r, gic.ap1r, gic.hcr, gic.vmcr);
+    return false;
 }
 
 void Vmcb::save_gst()
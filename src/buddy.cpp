@@ -50,20 +50,25 @@ Buddy::Buddy (mword virt, mword f_addr, size_t size)
     for (unsigned i = 0; i < order; i++)
         head[i].next = head[i].prev = head + i;
 
+    // Each CPU caches up to pcp_high pages per order plus pcp_high pre-zeroed pages
+    pcp_high = static_cast<unsigned>(min ((max_idx - min_idx) / pcp_share / NUM_CPU / (pcp_order + 1), static_cast<unsigned long>(pcp_max)));
+
     for (mword i = f_addr; i < index_to_page (max_idx); i += PAGE_SIZE)
         free (i);
 }
 
+Buddy::Pcp *Buddy::local()
+{
+    return EXPECT_TRUE (cpulocal()) ? pcp + Cpu::id : nullptr;
+}
+
 /*
- * Allocate physically contiguous memory region.
+ * Allocate block from the free lists (requires lock)
  * @param ord       Block order (2^ord pages)
- * @param zero      Zero out block content if true
- * @return          Pointer to linear memory region
+ * @return          Allocated block or nullptr
  */
-void *Buddy::alloc (uint16 ord, Fill fill)
+Buddy::Block *Buddy::alloc_block (uint16 ord)
 {
-    Lock_guard <Spinlock> guard (lock);
-
     for (auto j = ord; j < order; j++) {
 
         if (head[j].next == head + j)
@@ -83,41 +88,18 @@ void *Buddy::alloc (uint16 ord, Fill fill)
             head[j].next = head[j].prev = buddy;
         }
 
-        mword virt = index_to_page (block_to_index (block));
-
-        // Ensure corresponding physical block is order-aligned
-        assert ((virt_to_phys (virt) & ((1UL << (block->ord + PAGE_BITS)) - 1)) == 0);
-
-        if (fill)
-            memset (reinterpret_cast<void *>(virt), fill == FILL_0 ? 0 : -1, 1UL << (block->ord + PAGE_BITS));
-
-        return reinterpret_cast<void *>(virt);
+        return block;
     }
 
-    Console::panic ("Out of memory");
+    return nullptr;
 }
 
 /*
- * Free physically contiguous memory region.
- * @param virt     Linear block base address
+ * Return block to the free lists (requires lock)
+ * @param block     Block to be freed
  */
-void Buddy::free (mword virt)
+void Buddy::free_block (Block *block)
 {
-    auto idx = page_to_index (virt);
-
-    // Ensure virt is within allocator range
-    assert (idx >= min_idx && idx < max_idx);
-
-    Block *block = index_to_block (idx);
-
-    // Ensure block is marked as used
-    assert (block->tag == Block::Tag::USED);
-
-    // Ensure corresponding physical block is order-aligned
-    assert ((virt_to_phys (virt) & ((1UL << (block->ord + PAGE_BITS)) - 1)) == 0);
-
-    Lock_guard <Spinlock> guard (lock);
-
     uint16 ord;
     for (ord = block->ord; ord < order - 1; ord++) {
 
@@ -153,3 +135,167 @@ void Buddy::free (mword virt)
     block->next = h->next;
     block->next->prev = h->next = block;
 }
+
+/*
+ * Return all blocks of a CPU-local cache to the free lists (requires lock)
+ * @param p         CPU-local cache
+ */
+void Buddy::drain (Pcp *p)
+{
+    for (uint16 o = 0; o < pcp_order; p->count[o] = 0, o++)
+        for (Block *b; (b = p->head[o]); free_block (b))
+            p->head[o] = b->next;
+
+    for (Block *b; (b = p->zero); free_block (b))
+        p->zero = b->next;
+
+    p->count_zero = 0;
+}
+
+/*
+ * Allocate physically contiguous memory region.
+ * @param ord       Block order (2^ord pages)
+ * @param zero      Zero out block content if true
+ * @return          Pointer to linear memory region
+ */
+void *Buddy::alloc (uint16 ord, Fill fill)
+{
+    Block *block;
+    Pcp *p = local();
+
+    if (EXPECT_TRUE (p && ord < pcp_order)) {
+
+        // Take a page from the pre-zeroed pool
+        if (fill == FILL_0 && !ord && (block = p->zero)) {
+            p->zero = block->next;
+            p->count_zero--;
+            return reinterpret_cast<void *>(index_to_page (block_to_index (block)));
+        }
+
+        // Refill empty CPU-local cache with one batch
+        if (EXPECT_FALSE (!p->head[ord])) {
+
+            Lock_guard <Spinlock> guard (lock);
+
+            for (Block *b; p->count[ord] < pcp_batch (ord) && (b = alloc_block (ord)); p->count[ord]++) {
+                b->next = p->head[ord];
+                p->head[ord] = b;
+            }
+        }
+
+        if (EXPECT_TRUE ((block = p->head[ord]))) {
+            p->head[ord] = block->next;
+            p->count[ord]--;
+        }
+
+    } else {
+
+        Lock_guard <Spinlock> guard (lock);
+
+        block = alloc_block (ord);
+    }
+
+    // Give the blocks hoarded by this CPU back before declaring defeat
+    if (EXPECT_FALSE (!block)) {
+
+        Lock_guard <Spinlock> guard (lock);
+
+        if (p)
+            drain (p);
+
+        if (!(block = alloc_block (ord)))
+            Console::panic ("Out of memory");
+    }
+
+    mword virt = index_to_page (block_to_index (block));
+
+    // Ensure corresponding physical block is order-aligned
+    assert ((virt_to_phys (virt) & ((1UL << (block->ord + PAGE_BITS)) - 1)) == 0);
+
+    if (fill)
+        memset (reinterpret_cast<void *>(virt), fill == FILL_0 ? 0 : -1, 1UL << (block->ord + PAGE_BITS));
+
+    return reinterpret_cast<void *>(virt);
+}
+
+/*
+ * Free physically contiguous memory region.
+ * @param virt     Linear block base address
+ */
+void Buddy::free (mword virt)
+{
+    auto idx = page_to_index (virt);
+
+    // Ensure virt is within allocator range
+    assert (idx >= min_idx && idx < max_idx);
+
+    Block *block = index_to_block (idx);
+
+    // Ensure block is marked as used
+    assert (block->tag == Block::Tag::USED);
+
+    // Ensure corresponding physical block is order-aligned
+    assert ((virt_to_phys (virt) & ((1UL << (block->ord + PAGE_BITS)) - 1)) == 0);
+
+    Pcp *p = local();
+
+    if (EXPECT_TRUE (p && block->ord < pcp_order)) {
+
+        auto ord = block->ord;
+
+        // Cached blocks remain tagged as used so that they do not merge
+        block->next = p->head[ord];
+        p->head[ord] = block;
+
+        // Return one batch to the free lists above the high-water mark
+        if (EXPECT_FALSE (++p->count[ord] > pcp_high >> ord)) {
+
+            Lock_guard <Spinlock> guard (lock);
+
+            for (; p->count[ord] > pcp_batch (ord); p->count[ord]--) {
+                Block *b = p->head[ord];
+                p->head[ord] = b->next;
+                free_block (b);
+            }
+        }
+
+        return;
+    }
+
+    Lock_guard <Spinlock> guard (lock);
+
+    free_block (block);
+}
+
+/*
+ * Replenish the CPU-local pool of pre-zeroed pages.
+ * Called from the idle loop so that zeroing stays off the allocation path.
+ */
+void Buddy::fill_zero()
+{
+    Pcp *p = local();
+
+    if (EXPECT_FALSE (!p))
+        return;
+
+    while (p->count_zero < pcp_high) {
+
+        Block *block;
+
+        if ((block = p->head[0])) {
+            p->head[0] = block->next;
+            p->count[0]--;
+        } else {
+            Lock_guard <Spinlock> guard (lock);
+
+            if (!(block = alloc_block (0)))
+                return;
+        }
+
+        memset (reinterpret_cast<void *>(index_to_page (block_to_index (block))), 0, PAGE_SIZE);
+
+        block->next = p->zero;
+        p->zero = block;
+        p->count_zero++;
+    }
+}
@@ -21,8 +21,10 @@
 
 #include "assert.hpp"
 #include "bits.hpp"
+#include "initprio.hpp"
 #include "lock_guard.hpp"
 #include "slab.hpp"
+#include "stdio.hpp"
 
 Slab::Slab (Slab_cache *c) : cache (c)
 {
@@ -48,9 +50,19 @@ void Slab::free (void *ptr)
     head = e;
 }
 
-Slab_cache::Slab_cache (size_t s, size_t a) : size (align_up (s, alignof (Slab_elem))),
-                                              buff (align_up (size + sizeof (Slab_elem), a)),
-                                              elem ((PAGE_SIZE - sizeof (Slab)) / buff) {}
+INIT_PRIORITY (PRIO_SLAB)
+Slab_cache Slab_mag::cache ("MAG", sizeof (Slab_mag), 8);
+
+Slab_cache *Slab_cache::list;
+
+Slab_cache::Slab_cache (char const *n, size_t s, size_t a) : name (n),
+                                                             size (align_up (s, alignof (Slab_elem))),
+                                                             buff (align_up (size + sizeof (Slab_elem), a)),
+                                                             elem ((PAGE_SIZE - sizeof (Slab)) / buff),
+                                                             link (list)
+{
+    list = this;
+}
 
 void Slab_cache::grow()
 {
@@ -63,10 +75,79 @@ void Slab_cache::grow()
     head = curr = slab;
 }
 
+/*
+ * Magazines are only created on the allocation path. The free path can run
+ * from RCU callbacks in interrupt context, where we must not grow a cache.
+ */
+Slab_mag *Slab_cache::magazine (bool create)
+{
+    // The magazine cache itself has no magazine layer and early boot has no CPU-local data
+    if (EXPECT_FALSE (this == &Slab_mag::cache || !cpulocal()))
+        return nullptr;
+
+    Slab_mag *&m = mag[Cpu::id];
+
+    if (EXPECT_FALSE (!m && create))
+        m = new Slab_mag;
+
+    return m;
+}
+
 void *Slab_cache::alloc()
 {
+    Slab_mag *m = magazine (true);
+
+    if (EXPECT_TRUE (m && m->count)) {
+        m->hit++;
+        return m->elem[--m->count];
+    }
+
+    Lock_guard <Spinlock> guard (lock);
+
+    if (EXPECT_FALSE (!m))
+        return depot_alloc();
+
+    // Refill an empty magazine with one batch from the depot
+    for (; m->count < Slab_mag::batch; m->count++)
+        m->elem[m->count] = depot_alloc();
+
+    m->miss++;
+    m->refill += Slab_mag::batch;
+
+    return m->elem[--m->count];
+}
+
+void Slab_cache::free (void *ptr)
+{
+    Slab_mag *m = magazine (false);
+
+    if (EXPECT_TRUE (m && m->count < 2 * Slab_mag::batch)) {
+        m->elem[m->count++] = ptr;
+        return;
+    }
+
     Lock_guard <Spinlock> guard (lock);
 
+    if (EXPECT_FALSE (!m)) {
+        depot_free (ptr);
+        return;
+    }
+
+    // Drain the coldest batch of a full magazine to the depot
+    for (unsigned i = 0; i < Slab_mag::batch; i++)
+        depot_free (m->elem[i]);
+
+    for (unsigned i = Slab_mag::batch; i < m->count; i++)
+        m->elem[i - Slab_mag::batch] = m->elem[i];
+
+    m->count -= Slab_mag::batch;
+    m->drain += Slab_mag::batch;
+
+    m->elem[m->count++] = ptr;
+}
+
+void *Slab_cache::depot_alloc()
+{
     if (EXPECT_FALSE (!curr))
         grow();
 
@@ -82,10 +163,8 @@ void *Slab_cache::alloc()
     return ret;
 }
 
-void Slab_cache::free (void *ptr)
+void Slab_cache::depot_free (void *ptr)
 {
-    Lock_guard <Spinlock> guard (lock);
-
     Slab *slab = reinterpret_cast<Slab *>(reinterpret_cast<mword>(ptr) & ~PAGE_MASK);
 
     bool was_full = slab->full();
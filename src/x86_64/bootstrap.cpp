@@ -18,10 +18,12 @@
  * GNU General Public License version 2 for more details.
  */
 
+#include "cmdline.hpp"
 #include "compiler.hpp"
 #include "ec.hpp"
 #include "hip.hpp"
 #include "msr.hpp"
+#include "utcb.hpp"
 
 extern "C" NORETURN
 void bootstrap()
@@ -37,10 +39,20 @@ void bootstrap()
     // Barrier: wait for all ECs to arrive here
     for (Atomic::add (barrier, 1UL); barrier != Cpu::online; pause()) ;
 
+    if (Cmdline::bench)
+        Mdb::bench();
+
     Msr::write<uint64>(Msr::IA32_TSC, 0);
 
     // Create root task
     if (Cpu::bsp) {
+        if (Cmdline::bench) {
+            Sc::bench();
+            Timeout::bench();
+            Utcb::bench();
+            Utcb::bench_vmx();
+        }
+
         Hip::add_check();
         Ec *root_ec = new Ec (&Pd::root, NUM_EXC + 1, &Pd::root, Ec::root_invoke, Cpu::id, 0, USER_ADDR - 2 * PAGE_SIZE, 0);
         Sc *root_sc = new Sc (&Pd::root, NUM_EXC + 2, root_ec, Cpu::id, Sc::default_prio, Sc::default_quantum);
@@ -0,0 +1,134 @@
+/*
+ * Channel
+ *
+ * Copyright (C) 2019 Udo Steinberg, BedRock Systems, Inc.
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#include "atomic.hpp"
+#include "buddy.hpp"
+#include "ch.hpp"
+#include "stdio.hpp"
+
+INIT_PRIORITY (PRIO_SLAB)
+Slab_cache Ch::cache ("CH", sizeof (Ch), 32);
+
+Ch::Ch (Pd *own, mword sel, unsigned ord) : Kobject (CH, static_cast<Space_obj *>(own), sel, 0x3), ring (static_cast<Slot *>(Buddy::allocator.alloc (static_cast<uint16>(ord), Buddy::NOFILL))), mask ((PAGE_SIZE << ord) / sizeof (Slot) - 1), wr (0), rd (0), sleep (false)
+{
+    for (mword i = 0; i <= mask; i++)
+        ring[i].seq = i;
+
+    trace (TRACE_SYSCALL, "CH:%p created (MSG:%lu)", this, mask + 1);
+}
+
+Ch::~Ch()
+{
+    Buddy::allocator.free (reinterpret_cast<mword>(ring));
+}
+
+bool Ch::put (mword m)
+{
+    for (mword w = Atomic::load (wr);;) {
+
+        Slot *s = ring + (w & mask);
+
+        mword q = Atomic::load (s->seq);
+
+        if (q == w) {
+            if (Atomic::cmp_swap (wr, w, w + 1)) {
+                s->msg = m;
+                Atomic::store (s->seq, w + 1);
+                return true;
+            }
+        } else if (static_cast<long>(q - w) < 0)
+            return false;                       // Ring full
+        else
+            w = Atomic::load (wr);
+    }
+}
+
+mword Ch::send (mword const *msg, mword n)
+{
+    mword i;
+
+    for (i = 0; i < n && put (msg[i]); i++) ;
+
+    // One wakeup for the whole batch
+    if (EXPECT_TRUE (i))
+        wake();
+
+    return i;
+}
+
+mword Ch::recv (mword *msg, mword n)
+{
+    Lock_guard <Spinlock> guard (lock);
+
+    mword i;
+
+    for (i = 0; i < n; i++, rd++) {
+
+        Slot *s = ring + (rd & mask);
+
+        if (Atomic::load (s->seq) != rd + 1)
+            break;
+
+        msg[i] = s->msg;
+
+        Atomic::store (s->seq, rd + mask + 1);
+    }
+
+    return i;
+}
+
+void Ch::wait()
+{
+    Ec *ec = Ec::current;
+
+    {   Lock_guard <Spinlock> guard (lock);
+
+        Atomic::store (sleep, true);
+
+        // A sender that published before it could see the flag did not wake us
+        if (Atomic::load (ring[rd & mask].seq) == rd + 1) {
+            Atomic::store (sleep, head() != nullptr);
+            return;
+        }
+
+        enqueue (ec);
+    }
+
+    ec->block_sc();
+}
+
+void Ch::wake()
+{
+    if (EXPECT_TRUE (!Atomic::load (sleep)))
+        return;
+
+    Ec *ec;
+
+    for (;;) {
+
+        {   Lock_guard <Spinlock> guard (lock);
+
+            if (!dequeue (ec = head())) {
+                Atomic::store (sleep, false);
+                return;
+            }
+        }
+
+        // The receiver restarts its call and collects the messages
+        ec->release (Ec::sys_sm_ctrl);
+    }
+}
@@ -23,6 +23,7 @@
 #include "hpt.hpp"
 #include "string.hpp"
 
+bool Cmdline::bench;
 bool Cmdline::iommu;
 bool Cmdline::keyb;
 bool Cmdline::serial;
@@ -35,6 +36,7 @@ bool Cmdline::novpid;
 
 struct Cmdline::param_map Cmdline::map[] =
 {
+    { "bench",      &Cmdline::bench     },
     { "iommu",      &Cmdline::iommu     },
     { "keyb",       &Cmdline::keyb      },
     { "serial",     &Cmdline::serial    },
@@ -20,6 +20,7 @@
 
 #include "counter.hpp"
 #include "lowlevel.hpp"
+#include "slab.hpp"
 #include "stdio.hpp"
 
 unsigned    Counter::ipi[NUM_IPI];
@@ -33,6 +34,7 @@ unsigned    Counter::vtlb_fill;
 unsigned    Counter::vtlb_flush;
 unsigned    Counter::schedule;
 unsigned    Counter::helping;
+unsigned    Counter::timer_saved;
 uint64      Counter::cycles_idle;
 
 void Counter::dump()
@@ -45,8 +47,9 @@ void Counter::dump()
     trace (0, "VFLU: %16u", Counter::vtlb_flush);
     trace (0, "SCHD: %16u", Counter::schedule);
     trace (0, "HELP: %16u", Counter::helping);
+    trace (0, "TSAV: %16u", Counter::timer_saved);
 
-    Counter::vtlb_gpf = Counter::vtlb_hpf = Counter::vtlb_fill = Counter::vtlb_flush = Counter::schedule = Counter::helping = 0;
+    Counter::vtlb_gpf = Counter::vtlb_hpf = Counter::vtlb_fill = Counter::vtlb_flush = Counter::schedule = Counter::helping = Counter::timer_saved = 0;
 
     for (unsigned i = 0; i < sizeof (Counter::ipi) / sizeof (*Counter::ipi); i++)
         if (Counter::ipi[i]) {
@@ -77,4 +80,14 @@ void Counter::dump()
             trace (0, "VMI %#4x: %12u", i, Counter::vmi[i]);
             Counter::vmi[i] = 0;
         }
+
+    for (Slab_cache *c = Slab_cache::list; c; c = c->link) {
+
+        Slab_mag *m = c->local();
+
+        if (m && (m->hit || m->miss || m->drain)) {
+            trace (0, "MAG %6s: %10u hit %8u miss %8u refill %8u drain", c->name, m->hit, m->miss, m->refill, m->drain);
+            m->hit = m->miss = m->refill = m->drain = 0;
+        }
+    }
 }
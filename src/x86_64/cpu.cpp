@@ -23,6 +23,7 @@
 #include "bits.hpp"
 #include "cmdline.hpp"
 #include "counter.hpp"
+#include "fpu.hpp"
 #include "gdt.hpp"
 #include "hip.hpp"
 #include "idt.hpp"
@@ -32,7 +33,9 @@
 #include "pd.hpp"
 #include "stdio.hpp"
 #include "svm.hpp"
+#include "timeout.hpp"
 #include "tss.hpp"
+#include "utcb.hpp"
 #include "vmx.hpp"
 
 char const * const Cpu::vendor_string[] =
@@ -198,6 +201,8 @@ void Cpu::init()
 
     Lapic::init();
 
+    Timeout::init();
+
     Paddr phys; mword attr;
     Pd::kern.Space_mem::loc[id] = Hptp (Hpt::current());
     Pd::kern.Space_mem::loc[id].lookup (CPU_LOCAL_DATA, phys, attr);
@@ -215,6 +220,11 @@ void Cpu::init()
     if (EXPECT_TRUE (feature (FEAT_SMEP)))
         set_cr4 (get_cr4() | Cpu::CR4_SMEP);
 
+    Fpu::setup();
+
+    if (bsp)
+        Utcb::init();
+
     Vmcs::init();
     Vmcb::init();
 
@@ -27,12 +27,13 @@
 #include "vectors.hpp"
 
 INIT_PRIORITY (PRIO_SLAB)
-Slab_cache  Dmar::cache (sizeof (Dmar), 8);
+Slab_cache  Dmar::cache ("DMAR", sizeof (Dmar), 8);
 
 Dmar *      Dmar::list;
 Dmar_ctx *  Dmar::ctx = new Dmar_ctx;
 Dmar_irt *  Dmar::irt = new Dmar_irt;
 uint32      Dmar::gcmd = GCMD_TE;
+bool        Dmar::pst = true;
 
 Dmar::Dmar (Paddr p) : List<Dmar> (list), reg_base ((hwdev_addr -= PAGE_SIZE) | (p & PAGE_MASK)), invq (static_cast<Dmar_qi *>(Buddy::allocator.alloc (ord, Buddy::FILL_0))), invq_idx (0)
 {
@@ -57,6 +58,9 @@ Dmar::Dmar (Paddr p) : List<Dmar> (list), reg_base ((hwdev_addr -= PAGE_SIZE) |
         gcmd |= GCMD_IRE;
     }
 
+    if (!pi())
+        pst = false;
+
     if (qi()) {
         write<uint64>(REG_IQT, 0);
         write<uint64>(REG_IQA, Buddy::ptr_to_phys (invq));
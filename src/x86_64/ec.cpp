@@ -23,24 +23,27 @@
 #include "ec.hpp"
 #include "elf.hpp"
 #include "hip.hpp"
+#include "lapic.hpp"
+#include "pid.hpp"
 #include "rcu.hpp"
 #include "stdio.hpp"
 #include "svm.hpp"
+#include "vectors.hpp"
 #include "vmx.hpp"
 #include "vtlb.hpp"
 
 INIT_PRIORITY (PRIO_SLAB)
-Slab_cache Ec::cache (sizeof (Ec), 32);
+Slab_cache Ec::cache ("EC", sizeof (Ec), 32);
 
 Ec *Ec::current, *Ec::fpowner;
 
 // Constructors
-Ec::Ec (Pd *own, void (*f)(), unsigned c) : Kobject (EC, static_cast<Space_obj *>(own)), cont (f), utcb (nullptr), pd (own), prev (nullptr), next (nullptr), cpu (static_cast<uint16>(c)), glb (true), evt (0), timeout (this)
+Ec::Ec (Pd *own, void (*f)(), unsigned c) : Kobject (EC, static_cast<Space_obj *>(own)), cont (f), utcb (nullptr), pd (own), prev (nullptr), next (nullptr), fpu_traps (0), fpu_loads (0), fpu_score (0), cpu (static_cast<uint16>(c)), glb (true), evt (0), timeout (this)
 {
     trace (TRACE_SYSCALL, "EC:%p created (PD:%p Kernel)", this, own);
 }
 
-Ec::Ec (Pd *own, mword sel, Pd *p, void (*f)(), unsigned c, unsigned e, mword u, mword s) : Kobject (EC, static_cast<Space_obj *>(own), sel, 0xd), cont (f), pd (p), prev (nullptr), next (nullptr), cpu (static_cast<uint16>(c)), glb (!!f), evt (e), timeout (this)
+Ec::Ec (Pd *own, mword sel, Pd *p, void (*f)(), unsigned c, unsigned e, mword u, mword s) : Kobject (EC, static_cast<Space_obj *>(own), sel, 0xd), cont (f), pd (p), prev (nullptr), next (nullptr), fpu_traps (0), fpu_loads (0), fpu_score (0), cpu (static_cast<uint16>(c)), glb (!!f), evt (e), timeout (this)
 {
     // Make sure we have a PTAB for this CPU in the PD
     pd->Space_mem::init (c);
@@ -69,13 +72,17 @@ Ec::Ec (Pd *own, mword sel, Pd *p, void (*f)(), unsigned c, unsigned e, mword u,
 
         regs.dst_portal = NUM_VMI - 2;
         regs.vtlb = new Vtlb;
+        regs.xcr0 = Fpu::xcr0 & Fpu::XCR0_X87;
+        regs.pid = Vmcs::has_pi() ? new Pid (c) : nullptr;
+        regs.pi_on = 0;
 
         if (Hip::feature() & Hip::FEAT_VMX) {
 
             regs.vmcs = new Vmcs (reinterpret_cast<mword>(sys_regs() + 1),
                                   pd->Space_pio::walk(),
                                   pd->loc[c].root(),
-                                  pd->ept.root());
+                                  pd->ept.root(),
+                                  regs.pid ? Buddy::ptr_to_phys (regs.pid) : 0);
 
             regs.nst_ctrl<Vmcs>();
             regs.vmcs->clear();
@@ -93,6 +100,13 @@ Ec::Ec (Pd *own, mword sel, Pd *p, void (*f)(), unsigned c, unsigned e, mword u,
     }
 }
 
+Ec::~Ec()
+{
+    // The lending space must not keep a window into a dead EC
+    if (EXPECT_FALSE (win.active()))
+        Pd::unlend (win);
+}
+
 void Ec::handle_hazard (mword hzd, void (*func)())
 {
     if (hzd & HZD_RCU)
@@ -152,11 +166,14 @@ void Ec::handle_hazard (mword hzd, void (*func)())
     if (hzd & HZD_FPU)
         if (current != fpowner)
             Fpu::disable();
+
+    if (hzd & HZD_XCR0)
+        Fpu::set_xcr (Fpu::xcr0);
 }
 
 void Ec::ret_user_sysexit()
 {
-    mword hzd = (Cpu::hazard | current->regs.hazard()) & (HZD_RECALL | HZD_STEP | HZD_RCU | HZD_FPU | HZD_DS_ES | HZD_SCHED);
+    mword hzd = (Cpu::hazard | current->regs.hazard()) & (HZD_RECALL | HZD_STEP | HZD_RCU | HZD_FPU | HZD_XCR0 | HZD_DS_ES | HZD_SCHED);
     if (EXPECT_FALSE (hzd))
         handle_hazard (hzd, ret_user_sysexit);
 
@@ -168,7 +185,7 @@ void Ec::ret_user_sysexit()
 void Ec::ret_user_iret()
 {
     // No need to check HZD_DS_ES because IRET will reload both anyway
-    mword hzd = (Cpu::hazard | current->regs.hazard()) & (HZD_RECALL | HZD_STEP | HZD_RCU | HZD_FPU | HZD_SCHED);
+    mword hzd = (Cpu::hazard | current->regs.hazard()) & (HZD_RECALL | HZD_STEP | HZD_RCU | HZD_FPU | HZD_XCR0 | HZD_SCHED);
     if (EXPECT_FALSE (hzd))
         handle_hazard (hzd, ret_user_iret);
 
@@ -183,6 +200,8 @@ void Ec::ret_user_vmresume()
     if (EXPECT_FALSE (hzd))
         handle_hazard (hzd, ret_user_vmresume);
 
+    Fpu::set_xcr (current->regs.xcr0);
+
     current->regs.vmcs->make_current();
 
     if (EXPECT_FALSE (Pd::current->gtlb.chk (Cpu::id))) {
@@ -196,6 +215,13 @@ void Ec::ret_user_vmresume()
     if (EXPECT_FALSE (get_cr2() != current->regs.cr2))
         set_cr2 (current->regs.cr2);
 
+    // Switch to guest-mode notifications and replay those posted meanwhile
+    if (current->regs.pi_on) {
+        current->regs.pid->set_nv (VEC_IPI_PIN);
+        if (EXPECT_FALSE (current->regs.pid->pending()))
+            Lapic::send_self (VEC_IPI_PIN);
+    }
+
     asm volatile ("lea %0," EXPAND (PREG(sp); LOAD_GPR)
                   "vmresume;"
                   "vmlaunch;"
@@ -213,6 +239,8 @@ void Ec::ret_user_vmrun()
     if (EXPECT_FALSE (hzd))
         handle_hazard (hzd, ret_user_vmrun);
 
+    Fpu::set_xcr (current->regs.xcr0);
+
     if (EXPECT_FALSE (Pd::current->gtlb.chk (Cpu::id))) {
         Pd::current->gtlb.clr (Cpu::id);
         if (current->regs.nst_on)
@@ -247,6 +275,8 @@ void Ec::idle()
         if (EXPECT_FALSE (hzd))
             handle_hazard (hzd, idle);
 
+        Buddy::allocator.fill_zero();
+
         uint64 t1 = rdtsc();
         asm volatile ("sti; hlt; cli" : : : "memory");
         uint64 t2 = rdtsc();
@@ -28,6 +28,8 @@ void Ec::load_fpu()
     if (!utcb)
         regs.fpu_ctrl (true);
 
+    Fpu::set_xcr (utcb ? Fpu::xcr0 : regs.xcr0);
+
     if (EXPECT_FALSE (!fpu))
         Fpu::init();
     else
@@ -42,6 +44,8 @@ void Ec::save_fpu()
     if (!utcb)
         regs.fpu_ctrl (false);
 
+    Fpu::set_xcr (utcb ? Fpu::xcr0 : regs.xcr0);
+
     if (EXPECT_FALSE (!fpu))
         fpu = new Fpu;
 
@@ -63,6 +67,21 @@ void Ec::transfer_fpu (Ec *ec)
     fpowner = ec;
 }
 
+void Ec::adapt_fpu()
+{
+    if (--fpu_score < fpu_eager)
+        return;
+
+    fpu_loads++;
+
+    Fpu::enable();
+
+    fpowner->save_fpu();
+    load_fpu();
+
+    fpowner = this;
+}
+
 void Ec::handle_exc_nm()
 {
     Fpu::enable();
@@ -70,6 +89,9 @@ void Ec::handle_exc_nm()
     if (current == fpowner)
         return;
 
+    current->fpu_traps++;
+    current->fpu_score = min (current->fpu_score + fpu_boost, fpu_limit);
+
     fpowner->save_fpu();
     current->load_fpu();
 
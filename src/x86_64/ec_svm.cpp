@@ -144,6 +144,20 @@ void Ec::svm_cr()
     ret_user_vmrun();
 }
 
+void Ec::svm_xsetbv()
+{
+    uint64 val = static_cast<uint64>(current->regs.REG(dx)) << 32 | static_cast<uint32>(current->regs.vmcb->rax);
+
+    // Leave anything we do not support to the VMM
+    if (EXPECT_FALSE (static_cast<uint32>(current->regs.REG(cx)) || !Fpu::valid (val)))
+        return;
+
+    current->regs.xcr0 = val;
+
+    current->regs.vmcb->adjust_rip (3);
+    ret_user_vmrun();
+}
+
 void Ec::handle_svm()
 {
     current->regs.vmcb->tlb_control = 0;
@@ -177,6 +191,10 @@ void Ec::handle_svm()
 
         case 0x79:              // INVLPG
             svm_invlpg();
+
+        case 0x8d:              // XSETBV
+            svm_xsetbv();
+            break;
     }
 
     current->regs.dst_portal = reason;
@@ -23,6 +23,7 @@
 #include "ec.hpp"
 #include "gsi.hpp"
 #include "lapic.hpp"
+#include "pid.hpp"
 #include "vectors.hpp"
 #include "vmx.hpp"
 #include "vtlb.hpp"
@@ -132,10 +133,33 @@ void Ec::vmx_cr()
     ret_user_vmresume();
 }
 
+void Ec::vmx_xsetbv()
+{
+    uint64 val = static_cast<uint64>(current->regs.REG(dx)) << 32 | static_cast<uint32>(current->regs.REG(ax));
+
+    // Leave anything we do not support to the VMM
+    if (EXPECT_FALSE (static_cast<uint32>(current->regs.REG(cx)) || !Fpu::valid (val)))
+        return;
+
+    current->regs.xcr0 = val;
+
+    Vmcs::adjust_rip();
+    ret_user_vmresume();
+}
+
 void Ec::handle_vmx()
 {
     Cpu::hazard = (Cpu::hazard | HZD_DS_ES | HZD_TR) & ~HZD_FPU;
 
+    current->regs.gst.invalidate();
+
+    // A notification sent before the switch may be taken by the next vCPU
+    if (current->regs.pi_on) {
+        current->regs.pid->set_nv (VEC_IPI_PWK);
+        if (EXPECT_FALSE (current->regs.pid->pending()))
+            Lapic::send_self (VEC_IPI_PWK);
+    }
+
     mword reason = Vmcs::read (Vmcs::EXI_REASON) & 0xff;
 
     Counter::vmi[reason]++;
@@ -145,6 +169,7 @@ void Ec::handle_vmx()
         case Vmcs::VMX_EXTINT:      vmx_extint();
         case Vmcs::VMX_INVLPG:      vmx_invlpg();
         case Vmcs::VMX_CR:          vmx_cr();
+        case Vmcs::VMX_XSETBV:      vmx_xsetbv();   break;
         case Vmcs::VMX_EPT_VIOLATION:
             current->regs.nst_error = Vmcs::read (Vmcs::EXI_QUALIFICATION);
             current->regs.nst_fault = Vmcs::read (Vmcs::INFO_PHYS_ADDR);
@@ -16,7 +16,63 @@
  * GNU General Public License version 2 for more details.
  */
 
+#include "bits.hpp"
 #include "fpu.hpp"
+#include "msr.hpp"
+#include "stdio.hpp"
+
+Fpu::Mode   Fpu::mode;
+uint64      Fpu::xcr0;
+uint64      Fpu::xcr;
+
+// Sized for the state components of the boot CPU, before any Fpu exists
+INIT_PRIORITY (PRIO_SLAB)
+Slab_cache Fpu::cache ("FPU", Fpu::probe(), 64);
 
 INIT_PRIORITY (PRIO_SLAB)
-Slab_cache Fpu::cache (sizeof (Fpu), 16);
+Fpu Fpu::empty;
+
+size_t Fpu::probe()
+{
+    uint32 eax, ebx, ecx, edx;
+
+    Cpu::cpuid (0x1, eax, ebx, ecx, edx);
+
+    if (!(ecx & 1U << 26))
+        return sizeof (Fpu);
+
+    // AMX and MPX need more setup and PKRU needs CR4.PKE, so leave them disabled
+    Cpu::cpuid (0xd, 0, eax, ebx, ecx, edx);
+    xcr0 = eax & (XCR0_X87 | XCR0_SSE | XCR0_AVX | XCR0_AVX512);
+
+    Cpu::cpuid (0xd, 1, eax, ebx, ecx, edx);
+    mode = eax & 1U << 3 ? XSAVES : eax & 1U << 0 ? XSAVEOPT : XSAVE;
+
+    size_t size = sizeof (Fpu);
+
+    // Compacted format packs components in order, standard format uses fixed offsets
+    for (unsigned i = 2; i < 8; i++)
+        if (xcr0 & 1ULL << i) {
+            Cpu::cpuid (0xd, i, eax, ebx, ecx, edx);
+            size = mode == XSAVES ? (ecx & 2 ? align_up (size, 64) : size) + eax : max (size, static_cast<size_t>(ebx) + eax);
+        }
+
+    return size;
+}
+
+void Fpu::setup()
+{
+    if (mode == FXSR)
+        return;
+
+    set_cr4 (get_cr4() | Cpu::CR4_OSXSAVE);
+
+    if (mode == XSAVES)
+        Msr::write<uint64>(Msr::IA32_XSS, 0);
+
+    xcr = ~xcr0;
+
+    set_xcr (xcr0);
+
+    trace (TRACE_CPU, "FPU: XCR0:%#llx %s", xcr0, mode == XSAVES ? "XSAVES" : mode == XSAVEOPT ? "XSAVEOPT" : "XSAVE");
+}
@@ -21,15 +21,20 @@
 
 #include "acpi.hpp"
 #include "dmar.hpp"
+#include "ec.hpp"
 #include "gsi.hpp"
 #include "ioapic.hpp"
 #include "keyb.hpp"
 #include "lapic.hpp"
+#include "lock_guard.hpp"
+#include "pid.hpp"
 #include "sm.hpp"
 #include "vectors.hpp"
 
 Gsi         Gsi::gsi_table[NUM_GSI];
 unsigned    Gsi::irq_table[NUM_IRQ];
+Gsi *       Gsi::pin_list[NUM_CPU];
+Spinlock    Gsi::pin_lock;
 
 void Gsi::setup()
 {
@@ -50,7 +55,7 @@ void Gsi::setup()
     }
 }
 
-uint64 Gsi::set (unsigned gsi, unsigned cpu, unsigned rid)
+uint64 Gsi::set (unsigned gsi, unsigned cpu, unsigned rid, bool aff)
 {
     uint32 msi_addr = 0, msi_data = 0, aid = Cpu::apic_id[cpu];
 
@@ -67,9 +72,95 @@ uint64 Gsi::set (unsigned gsi, unsigned cpu, unsigned rid)
 
     Dmar::set_irt (gsi, rid, aid, VEC_GSI + gsi, gsi_table[gsi].trg);
 
+    {   Lock_guard <Spinlock> guard (pin_lock);
+        unpost (gsi_table[gsi]);
+    }
+
+    gsi_table[gsi].rid = static_cast<uint16>(rid);
+    gsi_table[gsi].cpu = static_cast<uint8>(cpu);
+    gsi_table[gsi].aff = aff;
+
     return static_cast<uint64>(msi_addr) << 32 | msi_data;
 }
 
+/*
+ * Move the interrupt to the CPU that waits for it, so that its wakeup
+ * needs no IPI. Without remapping, MSIs carry the destination in the
+ * device and stay where they are.
+ */
+void Gsi::steer (unsigned gsi, unsigned cpu)
+{
+    Gsi &g = gsi_table[gsi];
+
+    if (EXPECT_TRUE (!g.aff || g.cpu == cpu))
+        return;
+
+    uint32 aid = Cpu::apic_id[cpu];
+
+    if (Dmar::ire()) {
+        Dmar::set_irt (gsi, g.rid, aid, VEC_GSI + gsi, g.trg);
+        Dmar::flush_irt (gsi);
+    } else if (g.ioapic)
+        g.ioapic->set_cpu (gsi, aid);
+    else
+        return;
+
+    g.cpu = static_cast<uint8>(cpu);
+}
+
+/*
+ * Let the IOMMU post the interrupt into the descriptor of a vCPU. While
+ * the vCPU runs, it receives the vector without leaving guest mode.
+ */
+void Gsi::post (unsigned gsi, Pid *pid, unsigned cpu, unsigned vec)
+{
+    Gsi &g = gsi_table[gsi];
+
+    Dmar::set_pirt (gsi, g.rid, Buddy::ptr_to_phys (pid), vec);
+    Dmar::flush_irt (gsi);
+
+    Lock_guard <Spinlock> guard (pin_lock);
+
+    unpost (g);
+
+    g.cpu = static_cast<uint8>(cpu);
+    g.aff = false;
+    g.pid = pid;
+    g.pin = pin_list[cpu];
+    pin_list[cpu] = &g;
+}
+
+/*
+ * Remove the GSI from the posted list of its CPU (requires pin_lock)
+ */
+void Gsi::unpost (Gsi &g)
+{
+    if (!g.pid)
+        return;
+
+    for (Gsi **p = pin_list + g.cpu; *p; p = &(*p)->pin)
+        if (*p == &g) {
+            *p = g.pin;
+            break;
+        }
+
+    g.pid = nullptr;
+    g.pin = nullptr;
+}
+
+/*
+ * The wakeup vector arrived. A vCPU that is not in guest mode learns about
+ * its posted interrupts through the GSI semaphore.
+ */
+void Gsi::pin_handler()
+{
+    Lock_guard <Spinlock> guard (pin_lock);
+
+    for (Gsi *g = pin_list[Cpu::id]; g; g = g->pin)
+        if (g->pid->nv() != VEC_IPI_PIN && g->pid->pending())
+            g->sm->up();
+}
+
 void Gsi::mask (unsigned gsi)
 {
     Ioapic *ioapic = gsi_table[gsi].ioapic;
@@ -23,6 +23,7 @@
 #include "acpi.hpp"
 #include "cmdline.hpp"
 #include "ec.hpp"
+#include "gsi.hpp"
 #include "lapic.hpp"
 #include "msr.hpp"
 #include "rcu.hpp"
@@ -151,6 +152,7 @@ void Lapic::ipi_vector (unsigned vector)
     switch (vector) {
         case VEC_IPI_RRQ: Sc::rrq_handler(); break;
         case VEC_IPI_RKE: Sc::rke_handler(); break;
+        case VEC_IPI_PWK: Gsi::pin_handler(); break;
     }
 
     eoi();
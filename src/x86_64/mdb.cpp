@@ -17,17 +17,19 @@
  */
 
 #include "assert.hpp"
+#include "atomic.hpp"
+#include "cpu.hpp"
 #include "lock_guard.hpp"
+#include "lowlevel.hpp"
 #include "mdb.hpp"
+#include "stdio.hpp"
 
 INIT_PRIORITY (PRIO_SLAB)
-Slab_cache Mdb::cache (sizeof (Mdb), 16);
-
-Spinlock Mdb::lock;
+Slab_cache Mdb::cache ("MDB", sizeof (Mdb), 16);
 
 bool Mdb::insert_node (Mdb *p, mword a)
 {
-    Lock_guard <Spinlock> guard (lock);
+    Lock_guard <Spinlock> guard (p->root()->tree_lock);
 
     if (!p->alive())
         return false;
@@ -45,7 +47,7 @@ bool Mdb::insert_node (Mdb *p, mword a)
 
 void Mdb::demote_node (mword a)
 {
-    Lock_guard <Spinlock> guard (lock);
+    Lock_guard <Spinlock> guard (root()->tree_lock);
 
     node_attr &= ~a;
 }
@@ -55,7 +57,7 @@ bool Mdb::remove_node()
     if (node_attr)
         return false;
 
-    Lock_guard <Spinlock> guard (lock);
+    Lock_guard <Spinlock> guard (root()->tree_lock);
 
     if (!alive())
         return false;
@@ -68,3 +70,45 @@ bool Mdb::remove_node()
 
     return true;
 }
+
+void Mdb::bench()
+{
+    static Mdb *shared;
+    static mword barrier;
+
+    unsigned const rounds = 1000;
+
+    Mdb *root[2] = { new Mdb (nullptr, 0, Cpu::id, 0, 0x1f), nullptr };
+
+    if (Cpu::bsp)
+        shared = new Mdb (nullptr, 0, 0, 0, 0x1f);
+
+    uint64 cycles[2];
+
+    for (unsigned i = 0; i < 2; i++) {
+
+        // Barrier: all CPUs start each phase together
+        for (Atomic::add (barrier, 1UL); barrier < (i + 1) * Cpu::online; pause()) ;
+
+        Mdb *r = root[i] ? root[i] : shared;
+
+        uint64 t = rdtsc();
+
+        // Delegate and revoke one node below a private (disjoint) or common (shared) root
+        for (unsigned j = 0; j < rounds; j++) {
+            Mdb *node = new Mdb (nullptr, 0, j, 0);
+            node->insert_node (r, 0x1f);
+            node->demote_node (0x1f);
+            node->remove_node();
+            delete node;
+        }
+
+        cycles[i] = rdtsc() - t;
+    }
+
+    for (Atomic::add (barrier, 1UL); barrier < 3 * Cpu::online; pause()) ;
+
+    trace (TRACE_PERF, "MDB: %u CPUs disjoint %lu shared %lu cycles/op", Cpu::online, static_cast<mword>(cycles[0]) / rounds, static_cast<mword>(cycles[1]) / rounds);
+
+    delete root[0];
+}
@@ -24,7 +24,7 @@
 #include "stdio.hpp"
 
 INIT_PRIORITY (PRIO_SLAB)
-Slab_cache Pd::cache (sizeof (Pd), 32);
+Slab_cache Pd::cache ("PD", sizeof (Pd), 32);
 
 Pd *Pd::current;
 
@@ -217,17 +217,14 @@ void Pd::del_crd (Pd *pd, Crd del, Crd &crd, mword sub, mword hot)
     crd = Crd (rt, rb, o, a);
 }
 
-void Pd::rev_crd (Crd crd, bool self)
+bool Pd::rev (Crd crd, bool self)
 {
-    Cpu::preempt_enable();
-
     switch (crd.type()) {
 
         case Crd::MEM:
             trace (TRACE_REV, "REV MEM PD:%p B:%#010lx O:%#04x A:%#04x %s", this, crd.base(), crd.order(), crd.attr(), self ? "+" : "-");
             revoke<Space_mem>(crd.base(), crd.order(), crd.attr(), self);
-            shootdown();
-            break;
+            return true;
 
         case Crd::PIO:
             trace (TRACE_REV, "REV I/O PD:%p B:%#010lx O:%#04x A:%#04x %s", this, crd.base(), crd.order(), crd.attr(), self ? "+" : "-");
@@ -240,6 +237,61 @@ void Pd::rev_crd (Crd crd, bool self)
             break;
     }
 
+    return false;
+}
+
+void Pd::rev_crd (Crd crd, bool self)
+{
+    Cpu::preempt_enable();
+
+    if (rev (crd, self))
+        shootdown();
+
+    Cpu::preempt_disable();
+}
+
+void Pd::rev_items (Xfer *s, unsigned long ti, bool self)
+{
+    Cpu::preempt_enable();
+
+    // Update all page tables first, then shoot down stale TLB entries once
+    bool mem = false;
+
+    for (; ti--; s--)
+        mem |= rev (*s, self);
+
+    if (mem)
+        shootdown();
+
+    Cpu::preempt_disable();
+}
+
+/*
+ * Lend the memory at src to dst for the duration of a portal call, mapping
+ * it into the transfer window of the portal.
+ */
+void Pd::lend_crd (Window &w, Pd *dst, Crd src, Crd wnd)
+{
+    if (src.type() != Crd::MEM || wnd.type() != Crd::MEM)
+        return;
+
+    mword o = min (src.order(), wnd.order());
+
+    if (src.base() + (1UL << o) > USER_ADDR >> PAGE_BITS)
+        return;
+
+    trace (TRACE_DEL, "LND MEM PD:%p->%p SB:%#010lx DB:%#010lx O:%#04lx", this, dst, src.base(), wnd.base(), o);
+
+    lend (w, dst, src.base(), wnd.base(), o, src.attr() & wnd.attr());
+}
+
+void Pd::unlend (Window &w)
+{
+    Cpu::preempt_enable();
+
+    if (close (w))
+        shootdown();
+
     Cpu::preempt_disable();
 }
 
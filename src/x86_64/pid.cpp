@@ -0,0 +1,32 @@
+/*
+ * Posted-Interrupt Descriptor
+ *
+ * Copyright (C) 2019 Udo Steinberg, BedRock Systems, Inc.
+ *
+ * This file is part of the NOVA microhypervisor.
+ *
+ * NOVA is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * NOVA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ */
+
+#include "cpu.hpp"
+#include "pid.hpp"
+#include "vectors.hpp"
+
+INIT_PRIORITY (PRIO_SLAB)
+Slab_cache Pid::cache ("PID", sizeof (Pid), 64);
+
+Pid::Pid (unsigned cpu) : ctl (VEC_IPI_PWK << 16), dst (Cpu::apic_id[cpu] << 8)
+{
+    for (unsigned i = 0; i < sizeof (pir) / sizeof (*pir); i++)
+        pir[i] = 0;
+
+    for (unsigned i = 0; i < sizeof (res) / sizeof (*res); i++)
+        res[i] = 0;
+}
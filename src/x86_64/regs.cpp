@@ -238,6 +238,11 @@ void Exc_regs::vmx_set_cpu_ctrl0 (mword val)
     else
         val |= msk;
 
+    if (pi_on)
+        val |= Vmcs::CPU_TPR_SHADOW;
+    else
+        val &= ~Vmcs::CPU_TPR_SHADOW;
+
     val |= Vmcs::ctrl_cpu[0].set;
     val &= Vmcs::ctrl_cpu[0].clr;
 
@@ -253,10 +258,29 @@ void Exc_regs::vmx_set_cpu_ctrl1 (mword val)
     else
         val &= ~msk;
 
+    if (!pid)
+        val &= ~(Vmcs::CPU_VIRT_INTR | Vmcs::CPU_VIRT_X2APIC);
+
     val |= Vmcs::ctrl_cpu[1].set;
     val &= Vmcs::ctrl_cpu[1].clr;
 
+    // Guest EOIs must not exit to the VMM, which cannot reach the virtual APIC
+    if (!(val & Vmcs::CPU_VIRT_X2APIC))
+        val &= ~Vmcs::CPU_VIRT_INTR;
+
     Vmcs::write (Vmcs::CPU_EXEC_CTRL1, val);
+
+    if (!Vmcs::has_pi())
+        return;
+
+    // Virtual-interrupt delivery needs the TPR shadow and takes posted interrupts along
+    pi_on = !!(val & Vmcs::CPU_VIRT_INTR);
+
+    mword pin = Vmcs::read (Vmcs::PIN_CONTROLS);
+    Vmcs::write (Vmcs::PIN_CONTROLS, pi_on ? pin | Vmcs::PIN_POSTED : pin & ~Vmcs::PIN_POSTED);
+    Vmcs::write (Vmcs::MSR_BITMAP, Vmcs::msr_bmp[pi_on]);
+
+    vmx_set_cpu_ctrl0 (Vmcs::read (Vmcs::CPU_EXEC_CTRL0));
 }
 
 template <> void Exc_regs::nst_ctrl<Vmcb>(bool on)
@@ -26,7 +26,7 @@
 #include "vectors.hpp"
 
 INIT_PRIORITY (PRIO_SLAB)
-Slab_cache Sc::cache (sizeof (Sc), 32);
+Slab_cache Sc::cache ("SC", sizeof (Sc), 32);
 
 INIT_PRIORITY (PRIO_LOCAL)
 Sc::Rq Sc::rq;
@@ -37,7 +37,9 @@ unsigned    Sc::ctr_loop;
 
 Sc *Sc::list[Sc::priorities];
 
-unsigned Sc::prio_top;
+mword Sc::prio_map[Sc::priorities / Sc::prio_bits];
+
+mword Sc::prio_sum;
 
 Sc::Sc (Pd *own, mword sel, Ec *e) : Kobject (SC, static_cast<Space_obj *>(own), sel, 0x1), ec (e), cpu (static_cast<unsigned>(sel)), prio (0), budget (Lapic::freq_tsc * 1000), left (0), prev (nullptr), next (nullptr)
 {
@@ -54,12 +56,11 @@ void Sc::ready_enqueue (uint64 t)
     assert (prio < priorities);
     assert (cpu == Cpu::id);
 
-    if (prio > prio_top)
-        prio_top = prio;
-
-    if (!list[prio])
+    if (!list[prio]) {
         list[prio] = prev = next = this;
-    else {
+        prio_map[prio / prio_bits] |= 1UL << prio % prio_bits;
+        prio_sum |= 1UL << prio / prio_bits;
+    } else {
         next = list[prio];
         prev = list[prio]->prev;
         next->prev = prev->next = this;
@@ -67,7 +68,7 @@ void Sc::ready_enqueue (uint64 t)
             list[prio] = this;
     }
 
-    trace (TRACE_SCHEDULE, "ENQ:%p (%llu) PRIO:%#x TOP:%#x %s", this, left, prio, prio_top, prio > current->prio ? "reschedule" : "");
+    trace (TRACE_SCHEDULE, "ENQ:%p (%llu) PRIO:%#x TOP:%#x %s", this, left, prio, prio_top(), prio > current->prio ? "reschedule" : "");
 
     if (prio > current->prio || (this != current && prio == current->prio && left))
         Cpu::hazard |= HZD_SCHED;
@@ -87,14 +88,14 @@ void Sc::ready_dequeue (uint64 t)
     if (list[prio] == this)
         list[prio] = next == this ? nullptr : next;
 
+    if (!list[prio] && !(prio_map[prio / prio_bits] &= ~(1UL << prio % prio_bits)))
+        prio_sum &= ~(1UL << prio / prio_bits);
+
     next->prev = prev;
     prev->next = next;
     prev = next = nullptr;
 
-    while (!list[prio_top] && prio_top)
-        prio_top--;
-
-    trace (TRACE_SCHEDULE, "DEQ:%p (%llu) PRIO:%#x TOP:%#x", this, left, prio, prio_top);
+    trace (TRACE_SCHEDULE, "DEQ:%p (%llu) PRIO:%#x TOP:%#x", this, left, prio, prio_top());
 
     ec->add_tsc_offset (tsc - t);
 
@@ -119,7 +120,7 @@ void Sc::schedule (bool suspend)
     if (EXPECT_TRUE (!suspend))
         current->ready_enqueue (t);
 
-    Sc *sc = list[prio_top];
+    Sc *sc = list[prio_top()];
     assert (sc);
 
     Timeout_budget::budget.enqueue (t + sc->left);
@@ -175,6 +176,58 @@ void Sc::rrq_handler()
 
 void Sc::rke_handler()
 {
-    if (Pd::current->Space_mem::htlb.chk (Cpu::id))
+    unsigned gen = ACCESS_ONCE (Space_mem::tlb_gen);
+
+    if (Pd::current->Space_mem::htlb.chk (Cpu::id) && !Pd::current->tlb_flush (Cpu::id))
         Cpu::hazard |= HZD_SCHED;
+
+    Space_mem::tlb_ack = gen;
+}
+
+void Sc::bench()
+{
+    static struct {
+        char const *name;
+        unsigned    mask;
+        unsigned    base;
+    } const dist[] =
+    {
+        { "flat",   0,              default_prio    },  // All SCs on one level
+        { "spread", priorities - 1, 1               },  // SCs across all levels
+        { "sparse", 3,              priorities - 4  },  // Few high levels over idle
+    };
+
+    unsigned const num = 32, rounds = 1000;
+
+    Sc *sc[num];
+    auto hzd = Cpu::hazard;
+
+    for (unsigned d = 0; d < sizeof dist / sizeof *dist; d++) {
+
+        uint64 t = rdtsc();
+
+        for (unsigned i = 0; i < num; i++)
+            (sc[i] = new Sc (&Pd::kern, 0, Ec::current, Cpu::id, dist[d].base + (i * 7 & dist[d].mask) % (priorities - dist[d].base), default_quantum))->ready_enqueue (t);
+
+        uint64 t1 = rdtsc();
+
+        // Same ready-queue work as schedule(): requeue current with expired budget and pick the next SC
+        for (unsigned i = 0; i < rounds; i++) {
+            Sc *s = list[prio_top()];
+            s->ready_dequeue (t);
+            s->left = 0;
+            s->ready_enqueue (t);
+        }
+
+        uint64 t2 = rdtsc();
+
+        for (unsigned i = 0; i < num; i++) {
+            sc[i]->ready_dequeue (t);
+            delete sc[i];
+        }
+
+        trace (TRACE_PERF, "SCHD: %-6s %u SCs %lu cycles/schedule", dist[d].name, num, static_cast<mword>(t2 - t1) / rounds);
+    }
+
+    Cpu::hazard = hzd;
 }
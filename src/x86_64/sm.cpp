@@ -22,9 +22,37 @@
 #include "stdio.hpp"
 
 INIT_PRIORITY (PRIO_SLAB)
-Slab_cache Sm::cache (sizeof (Sm), 32);
+Slab_cache Sm::cache ("SM", sizeof (Sm), 32);
 
-Sm::Sm (Pd *own, mword sel, mword cnt) : Kobject (SM, static_cast<Space_obj *>(own), sel, 0x3), counter (cnt)
+Sm::Sm (Pd *own, mword sel, mword cnt, bool s) : Kobject (SM, static_cast<Space_obj *>(own), sel, 0x3), counter (s ? 0 : cnt), evs (nullptr), evt (0), set (s)
 {
-    trace (TRACE_SYSCALL, "SM:%p created (CNT:%lu)", this, cnt);
+    trace (TRACE_SYSCALL, "SM:%p created (CNT:%lu SET:%u)", this, cnt, s);
+}
+
+bool Sm::bind (Sm *s, unsigned bit)
+{
+    mword c;
+
+    {   Lock_guard <Spinlock> guard (lock);
+
+        if (EXPECT_FALSE (set || head()))
+            return false;
+
+        if (!s) {
+            evs = nullptr;
+            return true;
+        }
+
+        // Signals that arrived before the binding are passed on
+        c = counter;
+        counter = 0;
+
+        evt = 1UL << bit;
+        evs = s;
+    }
+
+    if (c)
+        s->signal (evt);
+
+    return true;
 }
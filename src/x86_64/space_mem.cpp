@@ -22,6 +22,7 @@
 #include "hazards.hpp"
 #include "hip.hpp"
 #include "lapic.hpp"
+#include "lock_guard.hpp"
 #include "mtrr.hpp"
 #include "pd.hpp"
 #include "stdio.hpp"
@@ -29,6 +30,8 @@
 #include "vectors.hpp"
 
 unsigned Space_mem::did_ctr;
+unsigned Space_mem::tlb_gen;
+unsigned Space_mem::tlb_ack;
 
 void Space_mem::init (unsigned cpu)
 {
@@ -73,22 +76,195 @@ void Space_mem::update (Mdb *mdb, mword r)
     if (mdb->node_base + (1UL << o) > USER_ADDR >> PAGE_BITS)
         return;
 
-    mword ord = min (o, Hpt::ord);
-    for (unsigned long i = 0; i < 1UL << (o - ord); i++)
-        hpt.update (b + i * (1UL << (ord + PAGE_BITS)), ord, p + i * (1UL << (ord + PAGE_BITS)), Hpt::hw_attr (a), r ? Hpt::TYPE_DN : Hpt::TYPE_UP);
+    {   Lock_guard <Spinlock> hpt_guard (hpt_lock);
+
+        mword ord = min (o, Hpt::ord);
+        for (unsigned long i = 0; i < 1UL << (o - ord); i++)
+            hpt.update (b + i * (1UL << (ord + PAGE_BITS)), ord, p + i * (1UL << (ord + PAGE_BITS)), Hpt::hw_attr (a), r ? Hpt::TYPE_DN : Hpt::TYPE_UP);
+
+        if (r)
+            for (unsigned i = 0; i < sizeof (loc) / sizeof (*loc); i++)
+                if (loc[i].addr())
+                    loc[i].update (b, o, p, Hpt::hw_attr (a), Hpt::TYPE_DF);
+    }
 
     if (r) {
 
-        for (unsigned i = 0; i < sizeof (loc) / sizeof (*loc); i++)
-            if (loc[i].addr())
-                loc[i].update (b, o, p, Hpt::hw_attr (a), Hpt::TYPE_DF);
+        tlb_add (b, o);
+
+        close (mdb->node_base, o);
+    }
+}
+
+/*
+ * Map the pages present in this space at sb into dst at db, with at most the
+ * permissions in attr. Window pages that dst has already mapped itself are
+ * left alone, only pages marked as lent are removed again when it closes.
+ * Pages that are themselves lent are not passed on, because revoking them
+ * would not reach the mapping database entry of this space.
+ */
+void Space_mem::lend (Window &w, Space_mem *dst, mword sb, mword db, mword ord, mword attr)
+{
+    Lock_guard <Spinlock> guard (win_lock);
+
+    if (EXPECT_FALSE (w.active()))
+        return;
+
+    Lock_guard <Spinlock> hpt_guard (dst->hpt_lock);
+
+    for (unsigned long i = 0; i < 1UL << ord; i++) {
+
+        mword s = (sb + i) << PAGE_BITS, d = (db + i) << PAGE_BITS, a, b;
+        Paddr p, q;
+
+        if (!hpt.lookup (s, p, a) || (a & (Hpt::HPT_U | Hpt::HPT_L)) != Hpt::HPT_U || dst->hpt.lookup (d, q, b))
+            continue;
+
+        a &= ~(Hpt::HPT_S | Hpt::HPT_G | (attr & 0x2 ? 0 : Hpt::HPT_W));
+
+        dst->map (d, p & ~PAGE_MASK, a | Hpt::HPT_L);
+    }
+
+    w.src = this;
+    w.dst = dst;
+    w.sb  = sb;
+    w.db  = db;
+    w.ord = ord;
+
+    w.next = win;
+    win = &w;
+}
+
+// Update a 4K mapping in the master and in the per-CPU page tables
+void Space_mem::map (mword v, Paddr p, mword a)
+{
+    hpt.update (v, 0, p, a, a ? Hpt::TYPE_UP : Hpt::TYPE_DN);
+
+    for (unsigned i = 0; i < sizeof (loc) / sizeof (*loc); i++)
+        if (loc[i].addr())
+            loc[i].update (v, 0, p, a, Hpt::TYPE_DF);
+}
+
+void Space_mem::unmap (Window &w)
+{
+    Window **ptr;
+    for (ptr = &win; *ptr != &w; ptr = &(*ptr)->next) ;
+    *ptr = w.next;
+
+    Lock_guard <Spinlock> guard (w.dst->hpt_lock);
+
+    for (unsigned long i = 0; i < 1UL << w.ord; i++) {
+
+        mword d = (w.db + i) << PAGE_BITS, b;
+        Paddr q;
+
+        if (w.dst->hpt.lookup (d, q, b) == PAGE_SIZE && b & Hpt::HPT_L)
+            w.dst->map (d, 0, 0);
+    }
+
+    w.dst->tlb_add (w.db << PAGE_BITS, w.ord);
+
+    w.src = nullptr;
+}
+
+/*
+ * Close all windows lent from the revoked range. The caller shoots down the
+ * stale TLB entries along with those of the revocation itself.
+ */
+void Space_mem::close (mword b, mword o)
+{
+    Lock_guard <Spinlock> guard (win_lock);
+
+    for (Window *w = win, *n; w; w = n) {
+
+        n = w->next;
+
+        if (w->sb < b + (1UL << o) && b < w->sb + (1UL << w->ord))
+            unmap (*w);
+    }
+}
+
+/*
+ * Close a window at the end of its portal call. Returns whether the window
+ * was still open, in which case the caller must shoot down stale TLB entries.
+ */
+bool Space_mem::close (Window &w)
+{
+    Space_mem *s = ACCESS_ONCE (w.src);
+
+    if (!s)
+        return false;
+
+    Lock_guard <Spinlock> guard (s->win_lock);
+
+    if (w.src != s)
+        return false;
+
+    s->unmap (w);
+
+    return true;
+}
+
+void Space_mem::tlb_add (mword b, mword o)
+{
+    Lock_guard <Spinlock> guard (tlb_lock);
+
+    tlb_rng[tlb_seq++ % tlb_slots] = b | o;
+
+    htlb.merge (cpus);
+}
+
+/*
+ * Invalidate the ranges revoked since the last flush on this CPU, which must
+ * have this space loaded. Fails if a full flush is required instead.
+ */
+bool Space_mem::tlb_flush (unsigned cpu)
+{
+    if (!tlb_lock.try_lock())
+        return false;
+
+    unsigned n = tlb_seq - tlb_done[cpu], e = 0;
+    bool ret = false;
+
+    if (n <= tlb_slots) {
+
+        for (unsigned i = tlb_seq - n; i != tlb_seq; i++) {
+            mword o = tlb_rng[i % tlb_slots] & PAGE_MASK, l = tlb_ord (o);
+            e += o - l < 16 ? 1U << (o - l) : tlb_max + 1;
+        }
+
+        if (e <= tlb_max) {
+
+            for (unsigned i = tlb_seq - n; i != tlb_seq; i++) {
+
+                mword b = tlb_rng[i % tlb_slots] & ~PAGE_MASK;
+                mword o = tlb_rng[i % tlb_slots] &  PAGE_MASK, l = tlb_ord (o);
 
-        htlb.merge (cpus);
+                for (unsigned long j = 0; j < 1UL << (o - l); j++)
+                    Hpt::flush (b + (j << (l + PAGE_BITS)));
+            }
+
+            tlb_done[cpu] = tlb_seq;
+            htlb.clr (cpu);
+            ret = true;
+        }
     }
+
+    tlb_lock.unlock();
+
+    return ret;
 }
 
+/*
+ * Send all IPIs first and then collect the acknowledgements. A CPU has
+ * acknowledged once it has observed the generation of this shootdown.
+ */
 void Space_mem::shootdown()
 {
+    unsigned gen = Atomic::add (tlb_gen, 1U);
+
+    Cpuset ipi;
+
     for (unsigned cpu = 0; cpu < NUM_CPU; cpu++) {
 
         if (!Hip::cpu_online (cpu))
@@ -100,17 +276,20 @@ void Space_mem::shootdown()
             continue;
 
         if (Cpu::id == cpu) {
-            Cpu::hazard |= HZD_SCHED;
+            if (!pd->tlb_flush (cpu))
+                Cpu::hazard |= HZD_SCHED;
             continue;
         }
 
-        unsigned ctr = Counter::remote (cpu, 1);
+        ipi.set (cpu);
 
         Lapic::send_ipi (cpu, VEC_IPI_RKE);
-
-        while (Counter::remote (cpu, 1) == ctr)
-            pause();
     }
+
+    for (unsigned cpu = 0; cpu < NUM_CPU; cpu++)
+        if (ipi.chk (cpu))
+            while (static_cast<int>(remote_ack (cpu) - gen) < 0)
+                pause();
 }
 
 void Space_mem::insert_root (uint64 s, uint64 e, mword a)
@@ -20,12 +20,14 @@
  * GNU General Public License version 2 for more details.
  */
 
+#include "ch.hpp"
 #include "dmar.hpp"
 #include "gsi.hpp"
 #include "hip.hpp"
 #include "hpet.hpp"
 #include "lapic.hpp"
 #include "pci.hpp"
+#include "pid.hpp"
 #include "pt.hpp"
 #include "sm.hpp"
 #include "stdio.hpp"
@@ -125,9 +127,19 @@ void Ec::sys_call()
     if (EXPECT_TRUE (!ec->cont)) {
         current->cont = ret_user_sysexit;
         current->set_partner (ec);
-        ec->cont = recv_user;
+        bool bulk = s->flags() & Sys_call::BULK_TRANSFER;
+        if (EXPECT_FALSE (bulk))
+            current->pd->lend_crd (current->win, ec->pd, s->bulk(), pt->win);
         ec->regs.set_pt (pt->id);
         ec->regs.set_ip (pt->ip);
+
+        // Register messages bypass the UTCB and enter the handler directly
+        if (pt->reg && EXPECT_TRUE (!bulk)) {
+            ec->regs.set_msg (&current->regs);
+            ec->cont = ret_user_sysexit;
+        } else
+            ec->cont = recv_user;
+
         ec->make_current();
     }
 
@@ -177,6 +189,9 @@ void Ec::reply (void (*c)())
 
     Ec *ec = current->rcap;
 
+    if (EXPECT_FALSE (ec && ec->win.active()))
+        Pd::unlend (ec->win);
+
     if (EXPECT_FALSE (!ec || !ec->clr_partner()))
         Sc::current->ec->activate();
 
@@ -189,6 +204,11 @@ void Ec::sys_reply()
 
     if (EXPECT_TRUE (ec)) {
 
+        if (EXPECT_TRUE (ec->cont == ret_user_sysexit && current->regs.flags() & Sys_reply::REG_MESSAGE)) {
+            ec->regs.set_msg (&current->regs);
+            reply();
+        }
+
         Utcb *src = current->utcb;
 
         bool fpu = false;
@@ -363,7 +383,24 @@ void Ec::sys_create_sm()
         sys_finish<Sys_regs::BAD_CAP>();
     }
 
-    Sm *sm = new Sm (Pd::current, r->sel(), r->cnt());
+    if (r->ch()) {
+
+        if (EXPECT_FALSE (r->cnt() > Ch::max)) {
+            trace (TRACE_ERROR, "%s: Bad ring order (%lu)", __func__, r->cnt());
+            sys_finish<Sys_regs::BAD_PAR>();
+        }
+
+        Ch *ch = new Ch (Pd::current, r->sel(), static_cast<unsigned>(r->cnt()));
+        if (!Space_obj::insert_root (ch)) {
+            trace (TRACE_ERROR, "%s: Non-NULL CAP (%#lx)", __func__, r->sel());
+            delete ch;
+            sys_finish<Sys_regs::BAD_CAP>();
+        }
+
+        sys_finish<Sys_regs::SUCCESS>();
+    }
+
+    Sm *sm = new Sm (Pd::current, r->sel(), r->cnt(), r->set());
     if (!Space_obj::insert_root (sm)) {
         trace (TRACE_ERROR, "%s: Non-NULL CAP (%#lx)", __func__, r->sel());
         delete sm;
@@ -379,7 +416,15 @@ void Ec::sys_revoke()
 
     trace (TRACE_SYSCALL, "EC:%p SYS_REVOKE", current);
 
-    Pd::current->rev_crd (r->crd(), r->flags());
+    if (r->batch()) {
+
+        if (EXPECT_FALSE (!current->utcb))
+            sys_finish<Sys_regs::BAD_PAR>();
+
+        Pd::current->rev_items (current->utcb->xfer(), current->utcb->ti(), r->self());
+
+    } else
+        Pd::current->rev_crd (r->crd(), r->self());
 
     sys_finish<Sys_regs::SUCCESS>();
 }
@@ -411,12 +456,35 @@ void Ec::sys_ec_ctrl()
 
     Ec *ec = static_cast<Ec *>(cap.obj());
 
-    if (!(ec->regs.hazard() & HZD_RECALL)) {
+    switch (r->op()) {
 
-        ec->regs.set_hazard (HZD_RECALL);
+        case 0:
+            if (!(ec->regs.hazard() & HZD_RECALL)) {
+
+                ec->regs.set_hazard (HZD_RECALL);
+
+                if (Cpu::id != ec->cpu && Ec::remote (ec->cpu) == ec)
+                    Lapic::send_ipi (ec->cpu, VEC_IPI_RKE);
+            }
+            break;
+
+        case 1:
+            r->set_fpu (ec->fpu_traps, ec->fpu_loads);
+            break;
+
+        case 2:
+            if (EXPECT_FALSE (!ec->pid() || r->vec() < 16 || r->vec() > 255)) {
+                trace (TRACE_ERROR, "%s: Bad vector (%#x)", __func__, r->vec());
+                sys_finish<Sys_regs::BAD_PAR>();
+            }
+
+            if (ec->pid()->post (r->vec()) && Cpu::id != ec->cpu && Ec::remote (ec->cpu) == ec)
+                Lapic::send_ipi (ec->cpu, ec->pid()->nv());
+            break;
 
-        if (Cpu::id != ec->cpu && Ec::remote (ec->cpu) == ec)
-            Lapic::send_ipi (ec->cpu, VEC_IPI_RKE);
+        default:
+            trace (TRACE_ERROR, "%s: Bad operation (%u)", __func__, r->op());
+            sys_finish<Sys_regs::BAD_PAR>();
     }
 
     sys_finish<Sys_regs::SUCCESS>();
@@ -450,6 +518,21 @@ void Ec::sys_pt_ctrl()
 
     Pt *pt = static_cast<Pt *>(cap.obj());
 
+    if (r->flags() & 1) {
+
+        Crd win = r->win();
+
+        if (EXPECT_FALSE (win.type() && (win.type() != Crd::MEM || win.order() > Window::max || win.base() + (1UL << win.order()) > USER_ADDR >> PAGE_BITS))) {
+            trace (TRACE_ERROR, "%s: Bad window (%#lx)", __func__, win.base());
+            sys_finish<Sys_regs::BAD_PAR>();
+        }
+
+        pt->set_win (win);
+    }
+
+    if (r->flags() & 2)
+        pt->set_reg (r->reg());
+
     pt->set_id (r->id());
 
     sys_finish<Sys_regs::SUCCESS>();
@@ -460,23 +543,72 @@ void Ec::sys_sm_ctrl()
     Sys_sm_ctrl *r = static_cast<Sys_sm_ctrl *>(current->sys_regs());
 
     Capability cap = Space_obj::lookup (r->sm());
-    if (EXPECT_FALSE (!cap.obj() || cap.obj()->type() != Kobject::SM || !(cap.prm() & 1UL << r->op()))) {
+    if (EXPECT_FALSE (!cap.obj() || (cap.obj()->type() != Kobject::SM && cap.obj()->type() != Kobject::CH) || !(cap.prm() & 1UL << r->op()))) {
         trace (TRACE_ERROR, "%s: Bad SM CAP (%#lx)", __func__, r->sm());
         sys_finish<Sys_regs::BAD_CAP>();
     }
 
+    // Channels move the untyped words of the UTCB through the ring
+    if (cap.obj()->type() == Kobject::CH) {
+
+        Ch *ch = static_cast<Ch *>(cap.obj());
+        Utcb *utcb = current->utcb;
+
+        if (EXPECT_FALSE (!utcb))
+            sys_finish<Sys_regs::BAD_PAR>();
+
+        mword n = utcb->ui(), m;
+
+        if (r->op()) {
+            while (!(m = ch->recv (utcb->msg(), n)) && n && !r->zc())
+                ch->wait();
+            utcb->set_ucnt (m);
+        } else
+            m = ch->send (utcb->msg(), n);
+
+        r->set_cnt (m);
+
+        if (EXPECT_FALSE (n && !m))
+            sys_finish<Sys_regs::COM_TIM>();
+
+        sys_finish<Sys_regs::SUCCESS>();
+    }
+
     Sm *sm = static_cast<Sm *>(cap.obj());
 
+    if (r->bind()) {
+
+        Capability set = Space_obj::lookup (r->evs());
+        if (EXPECT_FALSE (set.obj() && (set.obj()->type() != Kobject::SM || !static_cast<Sm *>(set.obj())->set || !(set.prm() & 1UL << 1)))) {
+            trace (TRACE_ERROR, "%s: Bad SET CAP (%#lx)", __func__, r->evs());
+            sys_finish<Sys_regs::BAD_CAP>();
+        }
+
+        if (EXPECT_FALSE (r->evt() >= sizeof (mword) * 8 || !sm->bind (static_cast<Sm *>(set.obj()), r->evt()))) {
+            trace (TRACE_ERROR, "%s: Bad SET member (%u)", __func__, r->evt());
+            sys_finish<Sys_regs::BAD_PAR>();
+        }
+
+        sys_finish<Sys_regs::SUCCESS>();
+    }
+
     switch (r->op()) {
 
         case 0:
+            // An event set is only signalled through its members
+            if (EXPECT_FALSE (sm->set)) {
+                trace (TRACE_ERROR, "%s: Up on SET (%#lx)", __func__, r->sm());
+                sys_finish<Sys_regs::BAD_PAR>();
+            }
             sm->up();
             break;
 
         case 1:
-            if (sm->space == static_cast<Space_obj *>(&Pd::kern))
+            if (sm->space == static_cast<Space_obj *>(&Pd::kern)) {
+                Gsi::steer (static_cast<unsigned>(sm->node_base - NUM_CPU), Cpu::id);
                 Gsi::unmask (static_cast<unsigned>(sm->node_base - NUM_CPU));
-            sm->dn (r->zc(), r->time());
+            }
+            sm->dn (r->zc(), r->time(), r->slack());
             break;
     }
 
@@ -538,7 +670,29 @@ void Ec::sys_assign_gsi()
         sys_finish<Sys_regs::BAD_DEV>();
     }
 
-    r->set_msi (Gsi::set (gsi, r->cpu(), rid));
+    Ec *vcpu = nullptr;
+
+    if (r->pst()) {
+
+        Capability cap = Space_obj::lookup (r->ec());
+        if (EXPECT_FALSE (!cap.obj() || cap.obj()->type() != Kobject::EC || !(cap.prm() & 1UL << 0))) {
+            trace (TRACE_ERROR, "%s: Bad EC CAP (%#lx)", __func__, r->ec());
+            sys_finish<Sys_regs::BAD_CAP>();
+        }
+
+        vcpu = static_cast<Ec *>(cap.obj());
+
+        // Posted entries cannot forward the EOI of a level-triggered pin
+        if (EXPECT_FALSE (!Dmar::pie() || !vcpu->pid() || r->vec() < 16 || r->vec() > 255 || (Gsi::gsi_table[gsi].ioapic && Gsi::gsi_table[gsi].trg))) {
+            trace (TRACE_ERROR, "%s: Cannot post GSI %u", __func__, gsi);
+            sys_finish<Sys_regs::BAD_PAR>();
+        }
+    }
+
+    r->set_msi (Gsi::set (gsi, r->cpu(), rid, r->aff()));
+
+    if (vcpu)
+        Gsi::post (gsi, vcpu->pid(), vcpu->cpu, r->vec());
 
     sys_finish<Sys_regs::SUCCESS>();
 }
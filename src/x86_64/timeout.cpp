@@ -15,49 +15,160 @@
  * GNU General Public License version 2 for more details.
  */
 
+#include "buddy.hpp"
+#include "counter.hpp"
 #include "lapic.hpp"
 #include "lowlevel.hpp"
+#include "stdio.hpp"
 #include "timeout.hpp"
 
-Timeout *Timeout::list;
+Timeout **  Timeout::wheel;
+Timeout *   Timeout::far;
+mword       Timeout::map[levels];
+uint64      Timeout::base;
+uint64      Timeout::dln;
 
-void Timeout::enqueue (uint64 t)
+void Timeout::init()
 {
-    time = t;
+    static_assert (levels * slots * sizeof (*wheel) <= PAGE_SIZE, "Timer wheel exceeds one page");
 
-    Timeout *p = nullptr;
+    wheel = static_cast<Timeout **>(Buddy::allocator.alloc (0, Buddy::FILL_0));
+    base  = 0;
+    dln   = ~0ULL;
+}
+
+void Timeout::insert (Timeout **h)
+{
+    head = h;
+
+    if (!*h)
+        *h = prev = next = this;
+
+    else {
+        next = *h;
+        prev = next->prev;
+        prev->next = next->prev = this;
+    }
+}
+
+void Timeout::place()
+{
+    uint64 t = max (time >> tick, base);
+
+    unsigned l = 0;
+    while (l < levels && t >> bits * (l + 1) != base >> bits * (l + 1))
+        l++;
+
+    if (l == levels) {
+        insert (&far);
+        return;
+    }
+
+    unsigned s = static_cast<unsigned>(t >> bits * l) & (slots - 1);
+
+    map[l] |= 1UL << s;
+
+    insert (wheel + l * slots + s);
+}
+
+void Timeout::collect (Timeout *&h, Timeout *&list)
+{
+    Timeout *t = h, *n;
+
+    do {
+        n = t->next;
+        t->head = nullptr;
+        t->next = list;
+        list = t;
+    } while ((t = n) != h);
+
+    h = nullptr;
+}
+
+void Timeout::program (uint64 t)
+{
+    if (t == dln)
+        return;
+
+    if ((dln = t) != ~0ULL)
+        Lapic::set_timer (t);
+}
+
+uint64 Timeout::expiry (Timeout *h)
+{
+    uint64 t = ~0ULL;
+
+    for (Timeout *n = h; t = min (t, n->time + n->slack), (n = n->next) != h; ) ;
+
+    return t;
+}
 
-    for (Timeout *n = list; n; p = n, n = n->next)
-        if (n->time >= time)
-            break;
+uint64 Timeout::earliest()
+{
+    uint64 t = ~0ULL;
+
+    // Walk the slots in time order until a slot starts after the earliest expiry found so far
+    for (unsigned l = 0; l < levels; l++) {
+
+        uint64 p = base >> bits * (l + 1) << bits * (l + 1);
+
+        for (mword m = map[l]; m; m &= m - 1) {
+
+            unsigned s = static_cast<unsigned>(bit_scan_forward (m));
 
-    prev = p;
+            if (t <= (p | static_cast<uint64>(s) << bits * l) << tick)
+                return t;
 
-    if (!p) {
-        next = list;
-        list = this;
-        Lapic::set_timer (time);
-    } else {
-        next = p->next;
-        p->next = this;
+            t = min (t, expiry (wheel[l * slots + s]));
+        }
     }
 
-    if (next)
-        next->prev = this;
+    return far ? min (t, expiry (far)) : t;
+}
+
+Timeout *Timeout::due (uint64 now)
+{
+    Timeout *h = wheel[base & (slots - 1)], *n = h;
+
+    if (h)
+        do {
+            if (n->time <= now)
+                return n;
+        } while ((n = n->next) != h);
+
+    return nullptr;
+}
+
+void Timeout::enqueue (uint64 t, uint64 s)
+{
+    time  = t;
+    slack = min (s, ~t);
+
+    place();
+
+    if (time + slack < dln)
+        program (time + slack);
 }
 
 uint64 Timeout::dequeue()
 {
     if (active()) {
 
-        if (next)
-            next->prev = prev;
+        if (*head == this)
+            *head = next == this ? nullptr : next;
 
-        if (prev)
-            prev->next = next;
+        prev->next = next;
+        next->prev = prev;
 
-        else if ((list = next))
-            Lapic::set_timer (list->time);
+        if (!*head && head != &far) {
+            unsigned i = static_cast<unsigned>(head - wheel);
+            map[i / slots] &= ~(1UL << i % slots);
+        }
+
+        head = nullptr;
+
+        if (time + slack <= dln)
+            program (earliest());
     }
 
     prev = next = nullptr;
@@ -67,9 +178,89 @@ uint64 Timeout::dequeue()
 
 void Timeout::check()
 {
-    while (list && list->time <= rdtsc()) {
-        Timeout *t = list;
+    uint64 now = rdtsc(), b = max (now >> tick, base);
+
+    Timeout *list = nullptr;
+
+    // Defer reprogramming the expired deadline until all due timeouts have fired
+    dln = 0;
+
+    // Collect all slots the wheel has advanced into
+    for (unsigned l = 0; l < levels; l++) {
+
+        uint64 p = base >> bits * (l + 1) << bits * (l + 1);
+
+        for (mword m = map[l]; m; m &= m - 1) {
+
+            unsigned s = static_cast<unsigned>(bit_scan_forward (m));
+
+            if ((p | static_cast<uint64>(s) << bits * l) > b)
+                break;
+
+            collect (wheel[l * slots + s], list);
+
+            map[l] &= ~(1UL << s);
+        }
+    }
+
+    if (far && b >> bits * levels != base >> bits * levels)
+        collect (far, list);
+
+    base = b;
+
+    // Requeue them relative to the new tick, expired ones onto the current slot
+    for (Timeout *n; list; list = n) {
+        n = list->next;
+        list->place();
+    }
+
+    unsigned n = 0;
+
+    for (Timeout *t; (t = due (now)); n++) {
         t->dequeue();
         t->trigger();
     }
+
+    // All but one of these would have needed their own interrupt
+    if (n > 1)
+        Counter::timer_saved += n - 1;
+
+    program (earliest());
+}
+
+void Timeout::bench()
+{
+    class Timeout_bench : public Timeout
+    {
+        private:
+            void trigger() override {}
+
+        public:
+            ALWAYS_INLINE
+            static inline void *operator new (size_t, void *p) { return p; }
+    };
+
+    unsigned const ord = 4, num = (PAGE_SIZE << ord) / sizeof (Timeout_bench);
+
+    Timeout_bench *t = static_cast<Timeout_bench *>(Buddy::allocator.alloc (ord, Buddy::NOFILL));
+
+    for (unsigned i = 0; i < num; i++)
+        new (t + i) Timeout_bench;
+
+    uint64 t0 = rdtsc();
+
+    // Deadlines scattered over several wheel levels, none of them due during the benchmark
+    for (unsigned i = 0; i < num; i++)
+        t[i].enqueue (t0 + (1ULL << 32) + (static_cast<uint64>(i * 2654435761U % num) << 20));
+
+    uint64 t1 = rdtsc();
+
+    for (unsigned i = 0; i < num; i++)
+        t[i * 7 % num].dequeue();
+
+    uint64 t2 = rdtsc();
+
+    trace (TRACE_PERF, "TMO: %u timeouts %lu cycles/enqueue %lu cycles/dequeue", num, static_cast<mword>(t1 - t0) / num, static_cast<mword>(t2 - t1) / num);
+
+    Buddy::allocator.free (reinterpret_cast<mword>(t));
 }
@@ -21,12 +21,190 @@
 #include "barrier.hpp"
 #include "config.hpp"
 #include "cpu.hpp"
+#include "hip.hpp"
 #include "lowlevel.hpp"
 #include "mtd.hpp"
 #include "regs.hpp"
+#include "stdio.hpp"
 #include "svm.hpp"
 #include "vmx.hpp"
 
+mword   Utcb::rep_min = ~0UL;
+bool    Utcb::rep_erms;
+
+static Vmcs::Encoding const vmx_enc[Vmcs_cache::FIELDS] =
+{
+    Vmcs::GUEST_SEL_ES,         Vmcs::GUEST_SEL_CS,         Vmcs::GUEST_SEL_SS,         Vmcs::GUEST_SEL_DS,
+    Vmcs::GUEST_SEL_FS,         Vmcs::GUEST_SEL_GS,         Vmcs::GUEST_SEL_LDTR,       Vmcs::GUEST_SEL_TR,
+    Vmcs::GUEST_LIMIT_ES,       Vmcs::GUEST_LIMIT_CS,       Vmcs::GUEST_LIMIT_SS,       Vmcs::GUEST_LIMIT_DS,
+    Vmcs::GUEST_LIMIT_FS,       Vmcs::GUEST_LIMIT_GS,       Vmcs::GUEST_LIMIT_LDTR,     Vmcs::GUEST_LIMIT_TR,
+    Vmcs::GUEST_LIMIT_GDTR,     Vmcs::GUEST_LIMIT_IDTR,
+    Vmcs::GUEST_AR_ES,          Vmcs::GUEST_AR_CS,          Vmcs::GUEST_AR_SS,          Vmcs::GUEST_AR_DS,
+    Vmcs::GUEST_AR_FS,          Vmcs::GUEST_AR_GS,          Vmcs::GUEST_AR_LDTR,        Vmcs::GUEST_AR_TR,
+    Vmcs::GUEST_BASE_ES,        Vmcs::GUEST_BASE_CS,        Vmcs::GUEST_BASE_SS,        Vmcs::GUEST_BASE_DS,
+    Vmcs::GUEST_BASE_FS,        Vmcs::GUEST_BASE_GS,        Vmcs::GUEST_BASE_LDTR,      Vmcs::GUEST_BASE_TR,
+    Vmcs::GUEST_BASE_GDTR,      Vmcs::GUEST_BASE_IDTR,
+    Vmcs::GUEST_RSP,            Vmcs::GUEST_RIP,            Vmcs::GUEST_RFLAGS,         Vmcs::GUEST_DR7,
+    Vmcs::GUEST_SYSENTER_CS,    Vmcs::GUEST_SYSENTER_ESP,   Vmcs::GUEST_SYSENTER_EIP,
+    Vmcs::GUEST_INTR_STATE,     Vmcs::GUEST_ACTV_STATE,     Vmcs::GUEST_EFER,
+};
+
+ALWAYS_INLINE
+static inline mword vmx_read (Vmcs_cache &c, unsigned f)
+{
+    if (!(c.vld & 1ULL << f)) {
+        c.val[f] = Vmcs::read (vmx_enc[f]);
+        c.vld |= 1ULL << f;
+    }
+
+    return c.val[f];
+}
+
+ALWAYS_INLINE
+static inline void vmx_write (Vmcs_cache &c, unsigned f, mword v)
+{
+    if (c.dirty (f, v))
+        Vmcs::write (vmx_enc[f], v);
+}
+
+ALWAYS_INLINE
+static inline void vmx_load_seg (Vmcs_cache &c, Utcb_segment &seg, unsigned i)
+{
+    seg.set_vmx (vmx_read (c, Vmcs_cache::SEL_ES + i), vmx_read (c, Vmcs_cache::BASE_ES + i), vmx_read (c, Vmcs_cache::LIMIT_ES + i), vmx_read (c, Vmcs_cache::AR_ES + i));
+}
+
+ALWAYS_INLINE
+static inline void vmx_save_seg (Vmcs_cache &c, Utcb_segment const &seg, unsigned i)
+{
+    vmx_write (c, Vmcs_cache::SEL_ES   + i,  seg.sel);
+    vmx_write (c, Vmcs_cache::BASE_ES  + i,  static_cast<mword>(seg.base));
+    vmx_write (c, Vmcs_cache::LIMIT_ES + i,  seg.limit);
+    vmx_write (c, Vmcs_cache::AR_ES    + i, (seg.ar << 4 & 0x1f000) | (seg.ar & 0xff));
+}
+
+void Utcb::init()
+{
+    // REP MOVSB pays off earlier with ERMS, plain string moves only for long messages
+    rep_erms = Cpu::feature (Cpu::FEAT_ERMS);
+    rep_min  = rep_erms ? 16 : 32;
+}
+
+void Utcb::bench()
+{
+    static mword const size[] = { 0, 4, 16, 64, 256, words };
+
+    unsigned const rounds = 1000;
+
+    Utcb *a = new Utcb, *b = new Utcb;
+
+    for (unsigned i = 0; i < sizeof size / sizeof *size; i++) {
+
+        a->items = b->items = size[i];
+
+        uint64 t0 = rdtsc();
+
+        // Message copies of an IPC round trip: call and reply
+        for (unsigned r = 0; r < rounds; r++) {
+            a->save (b);
+            b->save (a);
+        }
+
+        uint64 t1 = rdtsc();
+
+        for (unsigned r = 0; r < rounds; r++) {
+            for (mword w = 0; w < size[i]; w++)
+                b->mr[w] = a->mr[w];
+            for (mword w = 0; w < size[i]; w++)
+                a->mr[w] = b->mr[w];
+        }
+
+        uint64 t2 = rdtsc();
+
+        trace (TRACE_PERF, "UTCB: %3lu words %5lu cycles/round trip (word loop %5lu)", size[i], static_cast<mword>(t1 - t0) / rounds, static_cast<mword>(t2 - t1) / rounds);
+    }
+
+    // Register-carried call and reply, as used by register-message portals
+    Sys_regs x, y;
+
+    a->items = b->items = 3;
+
+    uint64 t0 = rdtsc();
+
+    for (unsigned r = 0; r < rounds; r++) {
+        a->save (b); barrier();
+        b->save (a); barrier();
+    }
+
+    uint64 t1 = rdtsc();
+
+    for (unsigned r = 0; r < rounds; r++) {
+        y.set_msg (&x); barrier();
+        x.set_msg (&y); barrier();
+    }
+
+    uint64 t2 = rdtsc();
+
+    trace (TRACE_PERF, "UTCB:   3 words %5lu cycles/round trip (registers %5lu)", static_cast<mword>(t1 - t0) / rounds, static_cast<mword>(t2 - t1) / rounds);
+
+    delete a;
+    delete b;
+}
+
+void Utcb::bench_vmx()
+{
+    if (!(Hip::feature() & Hip::FEAT_VMX))
+        return;
+
+    static mword const base = Mtd::GPR_ACDB | Mtd::GPR_BSD | Mtd::RIP_LEN | Mtd::QUAL;
+    static mword const sta  = base | Mtd::RSP | Mtd::RFLAGS | Mtd::STA | Mtd::INJ;
+    static mword const seg  = sta  | Mtd::DS_ES | Mtd::FS_GS | Mtd::CS_SS | Mtd::TR | Mtd::LDTR | Mtd::GDTR | Mtd::IDTR;
+    static mword const set[] = { base, sta, seg, seg | Mtd::DR | Mtd::SYSENTER | Mtd::EFER };
+
+    unsigned const rounds = 1000;
+
+    Cpu_regs regs;
+    regs.vmcs = new Vmcs (0, 0, 0, 0);
+    regs.dst_portal = 0;
+    regs.nst_on = 1;
+
+    Utcb *u = new Utcb;
+
+    unsigned fpu = 0;
+
+    for (unsigned i = 0; i < sizeof set / sizeof *set; i++) {
+
+        regs.mtd = set[i];
+
+        uint64 t0 = rdtsc();
+
+        // Guest state transfer of a VM exit handled by the VMM
+        for (unsigned r = 0; r < rounds; r++) {
+            regs.gst.invalidate();
+            fpu += u->load_vmx (&regs);
+            fpu += u->save_vmx (&regs);
+        }
+
+        uint64 t1 = rdtsc();
+
+        for (unsigned r = 0; r < rounds; r++) {
+            regs.gst.invalidate();
+            fpu += u->load_vmx (&regs);
+            regs.gst.invalidate();
+            fpu += u->save_vmx (&regs);
+        }
+
+        uint64 t2 = rdtsc();
+
+        trace (TRACE_PERF, "VMX: MTD %#07lx %5lu cycles/exit (uncached %5lu)", set[i], static_cast<mword>(t1 - t0) / rounds, static_cast<mword>(t2 - t1) / rounds);
+    }
+
+    regs.vmcs->clear();
+
+    Buddy::allocator.free (reinterpret_cast<mword>(regs.vmcs));
+
+    delete u;
+}
+
 bool Utcb::load_exc (Cpu_regs *regs)
 {
     mword m = regs->mtd;
@@ -111,43 +289,45 @@ bool Utcb::load_vmx (Cpu_regs *regs)
 
     regs->vmcs->make_current();
 
+    Vmcs_cache &c = regs->gst;
+
     if (m & Mtd::RSP)
-        rsp = Vmcs::read (Vmcs::GUEST_RSP);
+        rsp = vmx_read (c, Vmcs_cache::RSP);
 
     if (m & Mtd::RIP_LEN) {
-        rip      = Vmcs::read (Vmcs::GUEST_RIP);
+        rip      = vmx_read (c, Vmcs_cache::RIP);
         inst_len = Vmcs::read (Vmcs::EXI_INST_LEN);
     }
 
     if (m & Mtd::RFLAGS)
-        rflags = Vmcs::read (Vmcs::GUEST_RFLAGS);
+        rflags = vmx_read (c, Vmcs_cache::RFLAGS);
 
     if (m & Mtd::DS_ES) {
-        ds.set_vmx (Vmcs::read (Vmcs::GUEST_SEL_DS), Vmcs::read (Vmcs::GUEST_BASE_DS), Vmcs::read (Vmcs::GUEST_LIMIT_DS), Vmcs::read (Vmcs::GUEST_AR_DS));
-        es.set_vmx (Vmcs::read (Vmcs::GUEST_SEL_ES), Vmcs::read (Vmcs::GUEST_BASE_ES), Vmcs::read (Vmcs::GUEST_LIMIT_ES), Vmcs::read (Vmcs::GUEST_AR_ES));
+        vmx_load_seg (c, ds, 3);
+        vmx_load_seg (c, es, 0);
     }
 
     if (m & Mtd::FS_GS) {
-        fs.set_vmx (Vmcs::read (Vmcs::GUEST_SEL_FS), Vmcs::read (Vmcs::GUEST_BASE_FS), Vmcs::read (Vmcs::GUEST_LIMIT_FS), Vmcs::read (Vmcs::GUEST_AR_FS));
-        gs.set_vmx (Vmcs::read (Vmcs::GUEST_SEL_GS), Vmcs::read (Vmcs::GUEST_BASE_GS), Vmcs::read (Vmcs::GUEST_LIMIT_GS), Vmcs::read (Vmcs::GUEST_AR_GS));
+        vmx_load_seg (c, fs, 4);
+        vmx_load_seg (c, gs, 5);
     }
 
     if (m & Mtd::CS_SS) {
-        cs.set_vmx (Vmcs::read (Vmcs::GUEST_SEL_CS), Vmcs::read (Vmcs::GUEST_BASE_CS), Vmcs::read (Vmcs::GUEST_LIMIT_CS), Vmcs::read (Vmcs::GUEST_AR_CS));
-        ss.set_vmx (Vmcs::read (Vmcs::GUEST_SEL_SS), Vmcs::read (Vmcs::GUEST_BASE_SS), Vmcs::read (Vmcs::GUEST_LIMIT_SS), Vmcs::read (Vmcs::GUEST_AR_SS));
+        vmx_load_seg (c, cs, 1);
+        vmx_load_seg (c, ss, 2);
     }
 
     if (m & Mtd::TR)
-        tr.set_vmx (Vmcs::read (Vmcs::GUEST_SEL_TR), Vmcs::read (Vmcs::GUEST_BASE_TR), Vmcs::read (Vmcs::GUEST_LIMIT_TR), Vmcs::read (Vmcs::GUEST_AR_TR));
+        vmx_load_seg (c, tr, 7);
 
     if (m & Mtd::LDTR)
-        ld.set_vmx (Vmcs::read (Vmcs::GUEST_SEL_LDTR), Vmcs::read (Vmcs::GUEST_BASE_LDTR), Vmcs::read (Vmcs::GUEST_LIMIT_LDTR), Vmcs::read (Vmcs::GUEST_AR_LDTR));
+        vmx_load_seg (c, ld, 6);
 
     if (m & Mtd::GDTR)
-        gd.set_vmx (0, Vmcs::read (Vmcs::GUEST_BASE_GDTR), Vmcs::read (Vmcs::GUEST_LIMIT_GDTR), 0);
+        gd.set_vmx (0, vmx_read (c, Vmcs_cache::BASE_GDTR), vmx_read (c, Vmcs_cache::LIMIT_GDTR), 0);
 
     if (m & Mtd::IDTR)
-        id.set_vmx (0, Vmcs::read (Vmcs::GUEST_BASE_IDTR), Vmcs::read (Vmcs::GUEST_LIMIT_IDTR), 0);
+        id.set_vmx (0, vmx_read (c, Vmcs_cache::BASE_IDTR), vmx_read (c, Vmcs_cache::LIMIT_IDTR), 0);
 
     if (m & Mtd::CR) {
         cr0 = regs->read_cr<Vmcs> (0);
@@ -157,12 +337,12 @@ bool Utcb::load_vmx (Cpu_regs *regs)
     }
 
     if (m & Mtd::DR)
-        dr7 = Vmcs::read (Vmcs::GUEST_DR7);
+        dr7 = vmx_read (c, Vmcs_cache::DR7);
 
     if (m & Mtd::SYSENTER) {
-        sysenter_cs  = Vmcs::read (Vmcs::GUEST_SYSENTER_CS);
-        sysenter_rsp = Vmcs::read (Vmcs::GUEST_SYSENTER_ESP);
-        sysenter_rip = Vmcs::read (Vmcs::GUEST_SYSENTER_EIP);
+        sysenter_cs  = vmx_read (c, Vmcs_cache::SYSENTER_CS);
+        sysenter_rsp = vmx_read (c, Vmcs_cache::SYSENTER_ESP);
+        sysenter_rip = vmx_read (c, Vmcs_cache::SYSENTER_EIP);
     }
 
     if (m & Mtd::QUAL) {
@@ -186,8 +366,8 @@ bool Utcb::load_vmx (Cpu_regs *regs)
     }
 
     if (m & Mtd::STA) {
-        intr_state = static_cast<uint32>(Vmcs::read (Vmcs::GUEST_INTR_STATE));
-        actv_state = static_cast<uint32>(Vmcs::read (Vmcs::GUEST_ACTV_STATE));
+        intr_state = static_cast<uint32>(vmx_read (c, Vmcs_cache::INTR_STATE));
+        actv_state = static_cast<uint32>(vmx_read (c, Vmcs_cache::ACTV_STATE));
     }
 
     if (m & Mtd::TSC) {
@@ -197,7 +377,7 @@ bool Utcb::load_vmx (Cpu_regs *regs)
 
 #ifdef __x86_64__
     if (m & Mtd::EFER)
-        efer = Vmcs::read (Vmcs::GUEST_EFER);
+        efer = vmx_read (c, Vmcs_cache::EFER);
 #endif
 
     barrier();
@@ -224,72 +404,48 @@ bool Utcb::save_vmx (Cpu_regs *regs)
 
     regs->vmcs->make_current();
 
+    Vmcs_cache &c = regs->gst;
+
     if (mtd & Mtd::RSP)
-        Vmcs::write (Vmcs::GUEST_RSP, rsp);
+        vmx_write (c, Vmcs_cache::RSP, rsp);
 
     if (mtd & Mtd::RIP_LEN) {
-        Vmcs::write (Vmcs::GUEST_RIP, rip);
+        vmx_write (c, Vmcs_cache::RIP, rip);
         Vmcs::write (Vmcs::ENT_INST_LEN, inst_len);
     }
 
     if (mtd & Mtd::RFLAGS)
-        Vmcs::write (Vmcs::GUEST_RFLAGS, rflags);
+        vmx_write (c, Vmcs_cache::RFLAGS, rflags);
 
     if (mtd & Mtd::DS_ES) {
-        Vmcs::write (Vmcs::GUEST_SEL_DS,   ds.sel);
-        Vmcs::write (Vmcs::GUEST_BASE_DS,  static_cast<mword>(ds.base));
-        Vmcs::write (Vmcs::GUEST_LIMIT_DS, ds.limit);
-        Vmcs::write (Vmcs::GUEST_AR_DS,   (ds.ar << 4 & 0x1f000) | (ds.ar & 0xff));
-        Vmcs::write (Vmcs::GUEST_SEL_ES,   es.sel);
-        Vmcs::write (Vmcs::GUEST_BASE_ES,  static_cast<mword>(es.base));
-        Vmcs::write (Vmcs::GUEST_LIMIT_ES, es.limit);
-        Vmcs::write (Vmcs::GUEST_AR_ES,   (es.ar << 4 & 0x1f000) | (es.ar & 0xff));
+        vmx_save_seg (c, ds, 3);
+        vmx_save_seg (c, es, 0);
     }
 
     if (mtd & Mtd::FS_GS) {
-        Vmcs::write (Vmcs::GUEST_SEL_FS,   fs.sel);
-        Vmcs::write (Vmcs::GUEST_BASE_FS,  static_cast<mword>(fs.base));
-        Vmcs::write (Vmcs::GUEST_LIMIT_FS, fs.limit);
-        Vmcs::write (Vmcs::GUEST_AR_FS,   (fs.ar << 4 & 0x1f000) | (fs.ar & 0xff));
-        Vmcs::write (Vmcs::GUEST_SEL_GS,   gs.sel);
-        Vmcs::write (Vmcs::GUEST_BASE_GS,  static_cast<mword>(gs.base));
-        Vmcs::write (Vmcs::GUEST_LIMIT_GS, gs.limit);
-        Vmcs::write (Vmcs::GUEST_AR_GS,   (gs.ar << 4 & 0x1f000) | (gs.ar & 0xff));
+        vmx_save_seg (c, fs, 4);
+        vmx_save_seg (c, gs, 5);
     }
 
     if (mtd & Mtd::CS_SS) {
-        Vmcs::write (Vmcs::GUEST_SEL_CS,   cs.sel);
-        Vmcs::write (Vmcs::GUEST_BASE_CS,  static_cast<mword>(cs.base));
-        Vmcs::write (Vmcs::GUEST_LIMIT_CS, cs.limit);
-        Vmcs::write (Vmcs::GUEST_AR_CS,   (cs.ar << 4 & 0x1f000) | (cs.ar & 0xff));
-        Vmcs::write (Vmcs::GUEST_SEL_SS,   ss.sel);
-        Vmcs::write (Vmcs::GUEST_BASE_SS,  static_cast<mword>(ss.base));
-        Vmcs::write (Vmcs::GUEST_LIMIT_SS, ss.limit);
-        Vmcs::write (Vmcs::GUEST_AR_SS,   (ss.ar << 4 & 0x1f000) | (ss.ar & 0xff));
+        vmx_save_seg (c, cs, 1);
+        vmx_save_seg (c, ss, 2);
     }
 
-    if (mtd & Mtd::TR) {
-        Vmcs::write (Vmcs::GUEST_SEL_TR,     tr.sel);
-        Vmcs::write (Vmcs::GUEST_BASE_TR,    static_cast<mword>(tr.base));
-        Vmcs::write (Vmcs::GUEST_LIMIT_TR,   tr.limit);
-        Vmcs::write (Vmcs::GUEST_AR_TR,     (tr.ar << 4 & 0x1f000) | (tr.ar & 0xff));
-    }
+    if (mtd & Mtd::TR)
+        vmx_save_seg (c, tr, 7);
 
-    if (mtd & Mtd::LDTR) {
-        Vmcs::write (Vmcs::GUEST_SEL_LDTR,   ld.sel);
-        Vmcs::write (Vmcs::GUEST_BASE_LDTR,  static_cast<mword>(ld.base));
-        Vmcs::write (Vmcs::GUEST_LIMIT_LDTR, ld.limit);
-        Vmcs::write (Vmcs::GUEST_AR_LDTR,   (ld.ar << 4 & 0x1f000) | (ld.ar & 0xff));
-    }
+    if (mtd & Mtd::LDTR)
+        vmx_save_seg (c, ld, 6);
 
     if (mtd & Mtd::GDTR) {
-        Vmcs::write (Vmcs::GUEST_BASE_GDTR,  static_cast<mword>(gd.base));
-        Vmcs::write (Vmcs::GUEST_LIMIT_GDTR, gd.limit);
+        vmx_write (c, Vmcs_cache::BASE_GDTR,  static_cast<mword>(gd.base));
+        vmx_write (c, Vmcs_cache::LIMIT_GDTR, gd.limit);
     }
 
     if (mtd & Mtd::IDTR) {
-        Vmcs::write (Vmcs::GUEST_BASE_IDTR,  static_cast<mword>(id.base));
-        Vmcs::write (Vmcs::GUEST_LIMIT_IDTR, id.limit);
+        vmx_write (c, Vmcs_cache::BASE_IDTR,  static_cast<mword>(id.base));
+        vmx_write (c, Vmcs_cache::LIMIT_IDTR, id.limit);
     }
 
     if (mtd & Mtd::CR) {
@@ -297,15 +453,18 @@ bool Utcb::save_vmx (Cpu_regs *regs)
         regs->write_cr<Vmcs> (2, cr2);
         regs->write_cr<Vmcs> (3, cr3);
         regs->write_cr<Vmcs> (4, cr4);
+
+        // Toggling paging updates EFER.LMA behind the back of the cache
+        c.invalidate (Vmcs_cache::EFER);
     }
 
     if (mtd & Mtd::DR)
-        Vmcs::write (Vmcs::GUEST_DR7, dr7);
+        vmx_write (c, Vmcs_cache::DR7, dr7);
 
     if (mtd & Mtd::SYSENTER) {
-        Vmcs::write (Vmcs::GUEST_SYSENTER_CS,  sysenter_cs);
-        Vmcs::write (Vmcs::GUEST_SYSENTER_ESP, sysenter_rsp);
-        Vmcs::write (Vmcs::GUEST_SYSENTER_EIP, sysenter_rip);
+        vmx_write (c, Vmcs_cache::SYSENTER_CS,  sysenter_cs);
+        vmx_write (c, Vmcs_cache::SYSENTER_ESP, sysenter_rsp);
+        vmx_write (c, Vmcs_cache::SYSENTER_EIP, sysenter_rip);
     }
 
     if (mtd & Mtd::CTRL) {
@@ -334,15 +493,15 @@ bool Utcb::save_vmx (Cpu_regs *regs)
     }
 
     if (mtd & Mtd::STA) {
-        Vmcs::write (Vmcs::GUEST_INTR_STATE, intr_state);
-        Vmcs::write (Vmcs::GUEST_ACTV_STATE, actv_state);
+        vmx_write (c, Vmcs_cache::INTR_STATE, intr_state);
+        vmx_write (c, Vmcs_cache::ACTV_STATE, actv_state);
     }
 
     if (mtd & Mtd::TSC)
         regs->add_tsc_offset (tsc_off);
 
 #ifdef __x86_64__
-    if (mtd & Mtd::EFER)
+    if (mtd & Mtd::EFER && c.dirty (Vmcs_cache::EFER, efer))
         regs->write_efer<Vmcs> (efer);
 #endif
 
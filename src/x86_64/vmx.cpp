@@ -30,6 +30,7 @@
 #include "stdio.hpp"
 #include "tss.hpp"
 #include "util.hpp"
+#include "vectors.hpp"
 #include "vmx.hpp"
 
 Vmcs *              Vmcs::current;
@@ -42,8 +43,9 @@ Vmcs::vmx_ctrl_exi  Vmcs::ctrl_exi;
 Vmcs::vmx_ctrl_ent  Vmcs::ctrl_ent;
 mword               Vmcs::fix_cr0_set, Vmcs::fix_cr0_clr;
 mword               Vmcs::fix_cr4_set, Vmcs::fix_cr4_clr;
+mword               Vmcs::msr_bmp[2];
 
-Vmcs::Vmcs (mword esp, mword bmp, mword cr3, uint64 eptp) : rev (basic.revision)
+Vmcs::Vmcs (mword esp, mword bmp, mword cr3, uint64 eptp, mword pid) : rev (basic.revision)
 {
     make_current();
 
@@ -66,6 +68,21 @@ Vmcs::Vmcs (mword esp, mword bmp, mword cr3, uint64 eptp) : rev (basic.revision)
     write (IO_BITMAP_A, bmp);
     write (IO_BITMAP_B, bmp + PAGE_SIZE);
 
+    if (has_pi())
+        write (MSR_BITMAP, msr_bmp[0]);
+
+    // Virtual-interrupt delivery and posted interrupts, enabled by the VMM
+    if (pid) {
+        write (APIC_VIRT_ADDR, Buddy::ptr_to_phys (Buddy::allocator.alloc (0, Buddy::FILL_0)));
+        write (TPR_THRESHOLD, 0);
+        write (GUEST_INTR_STATUS, 0);
+        write (POSTED_INTR_NV, VEC_IPI_PIN);
+        write (POSTED_INTR_DESC, pid);
+
+        for (unsigned i = 0; i < 8; i++)
+            write (static_cast<Encoding>(EOI_EXIT_BITMAP + i), 0);
+    }
+
     write (HOST_SEL_CS, SEL_KERN_CODE);
     write (HOST_SEL_SS, SEL_KERN_DATA);
     write (HOST_SEL_DS, SEL_KERN_DATA);
@@ -128,6 +145,31 @@ void Vmcs::init()
     ctrl_cpu[0].set |= CPU_HLT | CPU_IO | CPU_IO_BITMAP | CPU_SECONDARY;
     ctrl_cpu[1].set |= CPU_VPID | CPU_URG;
 
+    if (!(ctrl_cpu[0].clr & CPU_TPR_SHADOW) || !(ctrl_cpu[0].clr & CPU_MSR_BITMAP) || !(ctrl_cpu[1].clr & CPU_VIRT_INTR) || !(ctrl_exi.clr & EXI_INTA))
+        ctrl_pin.clr &= ~PIN_POSTED;
+
+    if (has_pi()) {
+
+        ctrl_cpu[0].set |= CPU_MSR_BITMAP;
+
+        if (!msr_bmp[0]) {
+
+            static unsigned const x2apic[] = { 0x808, 0x80b, 0x83f };
+
+            uint8 *msr = static_cast<uint8 *>(Buddy::allocator.alloc (0, Buddy::FILL_1));
+
+            msr[0x808 / 8] &= static_cast<uint8>(~(1U << 0x808 % 8));
+
+            for (unsigned i = 0; i < sizeof (x2apic) / sizeof (*x2apic); i++)
+                msr[0x800 + x2apic[i] / 8] &= static_cast<uint8>(~(1U << x2apic[i] % 8));
+
+            msr_bmp[0] = Buddy::ptr_to_phys (Buddy::allocator.alloc (0, Buddy::FILL_1));
+            msr_bmp[1] = Buddy::ptr_to_phys (msr);
+        }
+
+    } else
+        ctrl_cpu[1].clr &= ~CPU_VIRT_INTR;
+
     if (Cmdline::vtlb || !ept_vpid.invept)
         ctrl_cpu[1].clr &= ~(CPU_EPT | CPU_URG);
     if (Cmdline::novpid || !ept_vpid.invvpid)
@@ -138,5 +180,5 @@ void Vmcs::init()
 
     Vmcs *root = new Vmcs;
 
-    trace (TRACE_VMX, "VMCS:%#010lx REV:%#x EPT:%d URG:%d VNMI:%d VPID:%d", Buddy::ptr_to_phys (root), basic.revision, has_ept(), has_urg(), has_vnmi(), has_vpid());
+    trace (TRACE_VMX, "VMCS:%#010lx REV:%#x EPT:%d URG:%d VNMI:%d VPID:%d PI:%d", Buddy::ptr_to_phys (root), basic.revision, has_ept(), has_urg(), has_vnmi(), has_vpid(), has_pi());
 }